@@ -6,21 +6,36 @@
 #include "attributes/abstract_attribute.hpp"
 
 #include "attributes/array_attribute.hpp"
+#include "attributes/attribute_set.hpp"
+#include "attributes/attributes_snapshot.hpp"
 #include "attributes/bool_attribute.hpp"
 #include "attributes/choice_attribute.hpp"
 #include "attributes/cloud_attribute.hpp"
 #include "attributes/color_attribute.hpp"
 #include "attributes/color_gradient_attribute.hpp"
+#include "attributes/compression.hpp"
 #include "attributes/enum_attribute.hpp"
 #include "attributes/filename_attribute.hpp"
 #include "attributes/float_attribute.hpp"
 #include "attributes/int_attribute.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/keyframe_track.hpp"
 #include "attributes/logger.hpp"
+#include "attributes/parameter_sweep.hpp"
 #include "attributes/path_attribute.hpp"
+#include "attributes/point_import.hpp"
+#include "attributes/preset_archive.hpp"
+#include "attributes/preset_io.hpp"
+#include "attributes/preset_journal.hpp"
+#include "attributes/preset_patch.hpp"
+#include "attributes/published_value.hpp"
 #include "attributes/range_attribute.hpp"
 #include "attributes/resolution_attribute.hpp"
 #include "attributes/seed_attribute.hpp"
+#include "attributes/shared_string.hpp"
 #include "attributes/string_attribute.hpp"
+#include "attributes/trace.hpp"
+#include "attributes/value_format.hpp"
 #include "attributes/vec2float_attribute.hpp"
 #include "attributes/vec_float_attribute.hpp"
 #include "attributes/vec_int_attribute.hpp"
@@ -2,14 +2,22 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #pragma once
+#include <atomic>
 #include <cfloat>  // FLT_MAX
 #include <climits> // INT_MAX
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
 #include "attributes/logger.hpp"
+#include "attributes/shared_string.hpp"
 #include "nlohmann/json.hpp"
 
 namespace attr
@@ -64,6 +72,63 @@ static std::map<AttributeType, std::string> attribute_type_map = {
     {AttributeType::WAVE_NB, "Wavenumber"},
 };
 
+// Float arrays keyed by JSON member name (see AbstractAttribute::json_from_bulk)
+using BulkArrays = std::map<std::string, std::vector<float>>;
+
+// =====================================
+// AttributeAllocation
+// =====================================
+
+// Storage of an attribute constructed by create_attr with a memory resource. It is
+// picked up by the AbstractAttribute constructor from the allocation pending on the
+// calling thread (see set_pending_attribute_allocation), copies do not propagate it.
+struct AttributeAllocation
+{
+  AttributeAllocation();
+  AttributeAllocation(const AttributeAllocation &) : AttributeAllocation() {}
+  AttributeAllocation &operator=(const AttributeAllocation &) { return *this; }
+
+  std::pmr::memory_resource *p_resource = nullptr; // nullptr for the global heap
+  size_t                     size = 0;
+  size_t                     alignment = 0;
+};
+
+void set_pending_attribute_allocation(std::pmr::memory_resource *p_resource,
+                                      size_t                     size,
+                                      size_t                     alignment);
+
+template <class T> class JsonSchema;
+
+// =====================================
+// MemoryUsage
+// =====================================
+
+// Memory used by an attribute, in bytes (see AbstractAttribute::memory_usage). Interned
+// strings (labels, descriptions, value formats) are shared by all the attributes and
+// not counted, allocator overheads are not counted either.
+struct MemoryUsage
+{
+  size_t value = 0;         // heap memory of the value, animation keys included
+  size_t state = 0;         // JSON snapshot of save_state
+  size_t initial_state = 0; // JSON snapshot of save_initial_state
+  size_t metadata = 0;      // attribute object, bounds, choice lists, presets...
+  size_t cache = 0;         // published snapshots, lazily built values, statistics
+
+  MemoryUsage &operator+=(const MemoryUsage &other);
+  size_t       total() const;
+  std::string  to_string() const;
+};
+
+// Memory used by the attributes of a map, 'entries' being keyed like the map.
+struct MemoryReport
+{
+  std::map<std::string, MemoryUsage> entries;
+  MemoryUsage                        total;
+
+  // One line per attribute, largest first, then the total.
+  std::string to_string() const;
+};
+
 // =====================================
 // AbstractAttribute
 // =====================================
@@ -74,17 +139,74 @@ public:
   AbstractAttribute(const AttributeType &type, const std::string &label);
   virtual ~AbstractAttribute() = default;
 
+  // Destroying delete: attributes constructed in a memory resource (see create_attr)
+  // are given back to it, so that they can be owned by a plain std::unique_ptr. With a
+  // monotonic resource the memory is only released with the resource.
+  void operator delete(AbstractAttribute *p_attr, std::destroying_delete_t);
+
   virtual void           json_from(nlohmann::json const &json);
   virtual nlohmann::json json_to() const;
 
-  std::string         get_label() const;
-  std::string         get_description() const;
+  // Write the compact JSON serialization (same content as json_to) to a stream. Derived
+  // classes with large payloads override it to avoid building the JSON tree.
+  virtual void json_write(std::ostream &os) const;
+
+  // Streaming deserialization used by the preset loader: the members listed by
+  // json_bulk_keys() are float arrays parsed straight into 'bulk' (no JSON tree), the
+  // other members are provided in 'json'. The default implementation merges both and
+  // calls json_from. json_to_bulk is the counterpart used by the binary preset archive,
+  // it returns the JSON state without the bulk members which are stored in 'bulk'.
+  virtual std::vector<std::string> json_bulk_keys() const { return {}; }
+  virtual void                     json_from_bulk(nlohmann::json const &json,
+                                                  BulkArrays           &bulk);
+  virtual nlohmann::json           json_to_bulk(BulkArrays &bulk) const;
+
+  SharedString        get_label() const;
+  SharedString        get_description() const;
   AttributeType       get_type() const;
+  uint64_t            get_hash() const;
   std::string         get_type_string() const;
+
+  // Memory resource the attribute is allocated from.
+  std::pmr::memory_resource *get_memory_resource() const;
+
+  uint64_t            get_version() const;
   void                set_label(const std::string &new_label);
   void                set_description(const std::string &new_description);
   virtual std::string to_string() = 0;
 
+  // The version is a monotonic counter bumped each time the value of the attribute may
+  // have changed (setters, json_from, state resets, write access through
+  // get_value_ref/edit_value). Comparing versions is a cheap way to detect changes.
+  void bump_version();
+
+  // Concurrent access: one writer thread (typically the GUI) and any number of reader
+  // threads (evaluation). get_version is safe from any thread. Scalar attributes (Bool,
+  // Float, Int, Seed) store their value in atomics, get_value is safe from any thread.
+  // Large values (Array, Cloud, Path, ColorGradient) are read from immutable snapshots
+  // (get_snapshot), which the writer thread makes available with publish, typically
+  // before launching an evaluation (modifications through edit_value must be done by
+  // then). publish is cheap when the value has not changed since the last call. Other
+  // accessors, including get_hash, belong to the writer thread.
+  virtual void publish() {}
+
+  // Digest of the attribute value (label and widget settings are not included). The
+  // default implementation hashes the serialized state, derived classes hash their typed
+  // value directly. Use get_hash() to get the digest memoized on the attribute version,
+  // it also accounts for the attribute type.
+  virtual uint64_t hash() const;
+
+  // Memory used by the attribute, see MemoryUsage. The JSON state snapshots are often
+  // much larger than the value they hold (a JSON node per array element). Derived
+  // classes add the size of their object and of their members to the base usage.
+  virtual MemoryUsage memory_usage() const;
+
+  // Set the value to the blend of the values of 'a' and 'b' with weight 't', clamped to
+  // [0, 1] (0 gives the value of 'a', 1 the value of 'b'). Either of them may be this
+  // attribute. Returns false, the value being left untouched, if 'a' or 'b' is not of
+  // the same type as this attribute.
+  bool blend(const AbstractAttribute &a, const AbstractAttribute &b, float t);
+
   // Get a pointer to the current attribute, cast to the requested type.
   template <class T = void> T *get_ref()
   {
@@ -107,11 +229,63 @@ public:
   void save_state();
 
 protected:
-  AttributeType  type = AttributeType::INVALID;
-  std::string    label = "";
-  std::string    description = "";
-  nlohmann::json attribute_state;
-  nlohmann::json attribute_initial_state;
+  // blend() implementation, 'a' and 'b' being of the same type as this attribute. The
+  // default implementation steps from the value of 'a' to the value of 'b' at t = 0.5
+  // (Bool, Choice, Enum, Seed...), attributes with continuous values interpolate and
+  // fall back to the step when the values are not compatible (e.g. different sizes).
+  virtual void blend_value(const AbstractAttribute &a,
+                           const AbstractAttribute &b,
+                           float                    t);
+
+  // reads "type" and "label"
+  template <class T> friend class JsonSchema;
+
+  AttributeAllocation   allocation;
+  AttributeType         type = AttributeType::INVALID;
+  SharedString          label;
+  SharedString          description;
+  nlohmann::json        attribute_state;
+  nlohmann::json        attribute_initial_state;
+
+  // bulk members of the saved states (see json_to_bulk), large arrays are stored as
+  // plain float vectors instead of a JSON node per element
+  BulkArrays attribute_state_bulk;
+  BulkArrays attribute_initial_state_bulk;
+  std::atomic<uint64_t> version = 0;
+
+  // get_hash() cache
+  mutable uint64_t hash_cache = 0;
+  mutable uint64_t hash_version = UINT64_MAX;
+};
+
+// =====================================
+// ValueWriteScope
+// =====================================
+
+// Write access to the value of an attribute. The attribute version is bumped when the
+// scope ends, i.e. once the modifications are done. Writing through the get_value_ref
+// accessors is deprecated: they bump the version before the caller writes, and the
+// caches keyed on the version (statistics, digests, Cloud buffers) may then keep the
+// value read in between.
+template <typename T> class ValueWriteScope
+{
+public:
+  ValueWriteScope(AbstractAttribute *p_attr, T *p_value)
+      : p_attr(p_attr), p_value(p_value)
+  {
+  }
+  ~ValueWriteScope() { this->p_attr->bump_version(); }
+
+  ValueWriteScope(const ValueWriteScope &) = delete;
+  ValueWriteScope &operator=(const ValueWriteScope &) = delete;
+
+  T &operator*() { return *this->p_value; }
+  T *operator->() { return this->p_value; }
+  T *get() { return this->p_value; }
+
+private:
+  AbstractAttribute *p_attr;
+  T                 *p_value;
 };
 
 // Helper - Creates a unique pointer to an attribute of the specified type.
@@ -121,6 +295,83 @@ std::unique_ptr<AttributeType> create_attr(Args &&...args)
   return std::make_unique<AttributeType>(std::forward<Args>(args)...);
 }
 
+// Helper - Creates a unique pointer to an attribute allocated from 'resource'. Typically
+// a std::pmr::monotonic_buffer_resource shared by all the attributes of a node, which
+// must outlive them: the attributes are then released at once with the resource.
+template <typename AttributeType, typename Resource, typename... Args>
+  requires std::is_base_of_v<std::pmr::memory_resource, Resource>
+std::unique_ptr<AttributeType> create_attr(Resource &resource, Args &&...args)
+{
+  const size_t size = sizeof(AttributeType);
+  const size_t alignment = alignof(AttributeType);
+
+  void *ptr = resource.allocate(size, alignment);
+  set_pending_attribute_allocation(&resource, size, alignment);
+
+  try
+  {
+    AttributeType *p_attr = new (ptr) AttributeType(std::forward<Args>(args)...);
+    return std::unique_ptr<AttributeType>(p_attr);
+  }
+  catch (...)
+  {
+    set_pending_attribute_allocation(nullptr, 0, 0);
+    resource.deallocate(ptr, size, alignment);
+    throw;
+  }
+}
+
+// Helper - Blend the attributes of the maps 'attr_map_a' and 'attr_map_b' with weight
+// 't' into the attributes of 'attr_map_dst' (see AbstractAttribute::blend), e.g. to
+// morph between two presets. The destination map may be one of the source maps. Returns
+// false if an attribute of the destination is missing in a source map or has a
+// different type, the other attributes are blended nonetheless.
+bool blend_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map_a,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map_b,
+    float                                                            t,
+    std::map<std::string, std::unique_ptr<AbstractAttribute>>       &attr_map_dst);
+
+// Helper - Fingerprint of an attribute map, combining the key and the attribute digest
+// of each entry in key order. Per-attribute digests are memoized on their version.
+uint64_t hash_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map);
+
+// Helper - Memory used by the attributes of a map, e.g. to check the parameters of a
+// project against a memory budget.
+MemoryReport memory_usage_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map);
+
+// Helper - Publish the values of the attributes of the map for reader threads (see
+// AbstractAttribute::publish), to be called from the writer thread.
+void publish_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map);
+
+// Helper - Human readable byte count, e.g. "1.5 MiB".
+std::string format_bytes(size_t nbytes);
+
+// Helper - Memory of a JSON tree, the root node excluded (estimate: node and container
+// sizes, not the allocator overheads).
+size_t json_memory_usage(const nlohmann::json &json);
+
+// Helper - Heap memory of a string, 0 if it fits in the string object (small string
+// optimization).
+size_t string_memory_usage(const std::string &str);
+
+// Helper - Heap memory of a vector, its capacity.
+template <typename T> size_t vector_memory_usage(const std::vector<T> &vec)
+{
+  return vec.capacity() * sizeof(T);
+}
+
+inline size_t vector_memory_usage(const std::vector<std::string> &vec)
+{
+  size_t n = vec.capacity() * sizeof(std::string);
+  for (auto &str : vec)
+    n += string_memory_usage(str);
+  return n;
+}
+
 // Helper - Safely deserialize json
 template <typename T>
 inline void json_safe_get(const nlohmann::json &j, const std::string &key, T &value)
@@ -135,6 +386,16 @@ inline void json_safe_get(const nlohmann::json &j, const std::string &key, T &va
   }
 }
 
+template <typename T>
+inline void json_safe_get(const nlohmann::json &j,
+                          const std::string    &key,
+                          std::atomic<T>       &value)
+{
+  T raw = value.load();
+  json_safe_get(j, key, raw);
+  value.store(raw);
+}
+
 inline void json_safe_get(const nlohmann::json &j,
                           const std::string    &key,
                           glm::vec2            &value)
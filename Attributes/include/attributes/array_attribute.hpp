@@ -2,15 +2,32 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #pragma once
+#include <cstdint>
+#include <mutex>
+
 #include <QImage>
 
 #include "highmap/array.hpp"
 
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/published_value.hpp"
+#include "attributes/range_attribute.hpp" // PairVec
 
 namespace attr
 {
 
+// =====================================
+// ArrayStats
+// =====================================
+
+struct ArrayStats
+{
+  float min = 0.f;
+  float max = 0.f;
+  float mean = 0.f;
+  float stddev = 0.f;
+};
+
 // =====================================
 // ArrayAttribute
 // =====================================
@@ -21,20 +38,60 @@ public:
   ArrayAttribute(const std::string &label, const glm::ivec2 &shape);
   ArrayAttribute(const std::string &label, const hmap::Array &value);
 
-  std::function<QImage()> get_background_image_fct() const;
-  glm::ivec2              get_shape() const { return this->value.shape; }
-  hmap::Array             get_value() const { return this->value; }
-  hmap::Array            *get_value_ref() { return &this->value; }
-  void                    set_background_image_fct(std::function<QImage()> new_fct);
-  void        set_value(const hmap::Array &new_value) { this->value = new_value; }
-  std::string to_string();
+  ValueWriteScope<hmap::Array> edit_value();
+  std::function<QImage()>      get_background_image_fct() const;
+  glm::ivec2                   get_shape() const { return this->value.shape; }
+  hmap::Array                  get_value() const { return this->value; }
+  const hmap::Array           &get_value_cref() const; // read-only, writer thread
+  // deprecated for writes, see edit_value
+  hmap::Array                 *get_value_ref();
+  void                         set_background_image_fct(std::function<QImage()> new_fct);
+  void                         set_value(const hmap::Array &new_value);
+  std::string                  to_string();
+
+  // Statistics are computed on demand in a single parallel pass and cached until the
+  // value is modified (i.e. until the attribute version changes). The histogram is
+  // returned as {bin centers, bin counts normalized by the number of cells} so that it
+  // can be used as-is for a RangeAttribute histogram function. Non-finite values (NaN,
+  // inf) are left out of both. The caches are guarded, both can be called from any
+  // thread as long as the value is not modified meanwhile.
+  ArrayStats get_stats() const;
+  PairVec    get_histogram(int nbins = 32) const;
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  void           json_write(std::ostream &os) const override;
+
+  std::vector<std::string> json_bulk_keys() const override;
+  void                     json_from_bulk(nlohmann::json const &json,
+                                          BulkArrays           &bulk) override;
+  nlohmann::json           json_to_bulk(BulkArrays &bulk) const override;
+  uint64_t                 hash() const override;
+  MemoryUsage              memory_usage() const override;
+
+  // Reader threads, see AbstractAttribute::publish.
+  std::shared_ptr<const hmap::Array> get_snapshot() const;
+  void                               publish() override;
+
+protected:
+  void blend_value(const AbstractAttribute &a,
+                   const AbstractAttribute &b,
+                   float                    t) override;
 
 private:
   hmap::Array             value;
   std::function<QImage()> background_image_fct = nullptr;
+
+  // snapshot for reader threads
+  PublishedValue<hmap::Array> published_value;
+
+  // statistics cache
+  mutable std::mutex cache_mutex;
+  mutable ArrayStats stats;
+  mutable uint64_t   stats_version = UINT64_MAX;
+  mutable PairVec    histogram;
+  mutable int        histogram_nbins = 0;
+  mutable uint64_t   histogram_version = UINT64_MAX;
 };
 
 } // namespace attr
@@ -0,0 +1,133 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "attributes/abstract_attribute.hpp"
+#include "attributes/attributes_snapshot.hpp"
+
+namespace attr
+{
+
+// Attribute keys are interned process-wide to integer ids: a key string always maps to
+// the same id, so that ids can be resolved once (e.g. stored in a static) and used for
+// every lookup instead of comparing strings. The interning table is thread-safe.
+
+using AttributeKeyId = uint32_t;
+
+#define ATTR_INVALID_KEY_ID UINT32_MAX
+#define ATTR_SET_ARENA_BLOCK_SIZE 4096
+
+// Id of 'key', interned on first use.
+AttributeKeyId intern_key(const std::string &key);
+
+// Id of 'key' if it has already been interned, ATTR_INVALID_KEY_ID otherwise (the key is
+// then in no set).
+AttributeKeyId find_key_id(const std::string &key);
+
+const std::string &get_key_string(AttributeKeyId id);
+
+// =====================================
+// AttributeSet
+// =====================================
+
+// Attribute container keyed by interned ids. Lookup is a binary search over a sorted flat
+// vector of ids, iteration follows the insertion order. Attributes created with emplace
+// are constructed in a monotonic arena owned by the set (contiguous blocks, released at
+// once with the set). Existing attributes can also be adopted or referenced, which is
+// how the set is built from the std::map containers used elsewhere.
+class AttributeSet
+{
+public:
+  AttributeSet() = default;
+  ~AttributeSet();
+
+  // Adapter - take ownership of the attributes of the map (the map is left empty).
+  explicit AttributeSet(
+      std::map<std::string, std::unique_ptr<AbstractAttribute>> &&attr_map);
+
+  AttributeSet(const AttributeSet &) = delete;
+  AttributeSet &operator=(const AttributeSet &) = delete;
+  AttributeSet(AttributeSet &&) = default;
+  AttributeSet &operator=(AttributeSet &&other);
+
+  // Add an attribute owned by the set, returns false if the key is already used.
+  bool adopt(const std::string &key, std::unique_ptr<AbstractAttribute> p_attr);
+
+  // Add an attribute owned by someone else, it must outlive the set. Returns false if
+  // the key is already used.
+  bool add_ref(const std::string &key, AbstractAttribute *p_attr);
+
+  // Throw std::out_of_range if the key is missing (as std::map::at).
+  AbstractAttribute *at(AttributeKeyId id) const;
+  AbstractAttribute *at(const std::string &key) const;
+
+  // Remove every attribute, the ones owned by the set are destroyed and the arena is
+  // released.
+  void clear();
+
+  bool contains(AttributeKeyId id) const;
+  bool contains(const std::string &key) const;
+
+  // Construct an attribute in the arena, returns nullptr if the key is already used.
+  template <typename T, typename... Args>
+  T *emplace(const std::string &key, Args &&...args)
+  {
+    AttributeKeyId id = intern_key(key);
+
+    if (this->contains(id))
+    {
+      Logger::log()->error("AttributeSet::emplace: key {} already in use", key);
+      return nullptr;
+    }
+
+    if (!this->arena)
+      this->arena = std::make_unique<std::pmr::monotonic_buffer_resource>(
+          ATTR_SET_ARENA_BLOCK_SIZE);
+
+    std::unique_ptr<T> p_attr = create_attr<T>(*this->arena, std::forward<Args>(args)...);
+    T                 *ptr = p_attr.get();
+
+    this->owned_attrs.push_back(std::move(p_attr));
+    this->insert(id, ptr);
+    return ptr;
+  }
+
+  bool empty() const;
+
+  // Nullptr if the key is missing.
+  AbstractAttribute *find(AttributeKeyId id) const;
+  AbstractAttribute *find(const std::string &key) const;
+
+  // Keys in insertion order, the attribute of the k-th key is get_attributes()[k].
+  const std::vector<AbstractAttribute *> &get_attributes() const;
+  const std::vector<AttributeKeyId>      &get_key_ids() const;
+  std::vector<std::string>                get_keys() const;
+
+  size_t size() const;
+
+  // Immutable copy of the values for a worker thread, see AttributesSnapshot.
+  std::shared_ptr<const AttributesSnapshot> snapshot() const;
+
+private:
+  void insert(AttributeKeyId id, AbstractAttribute *p_attr);
+
+  std::vector<AttributeKeyId>                          key_ids;
+  std::vector<AbstractAttribute *>                     attrs;
+  std::vector<std::pair<AttributeKeyId, uint32_t>>     sorted; // (id, index in attrs)
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+  std::vector<std::unique_ptr<AbstractAttribute>>      owned_attrs;
+};
+
+// Adapter - non-owning set referencing the attributes of the map, which must outlive
+// the set.
+AttributeSet attribute_set_view(
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map);
+
+} // namespace attr
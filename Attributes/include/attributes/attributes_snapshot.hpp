@@ -0,0 +1,143 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "attributes/abstract_attribute.hpp"
+
+namespace attr
+{
+
+// Version of the values set on a snapshot, which do not come from an attribute
+#define ATTR_SNAPSHOT_NO_VERSION UINT64_MAX
+
+// Snapshot values of the attributes whose get_value() is only part of their state
+struct EnumSnapshot
+{
+  int         value = 0;
+  std::string choice;
+};
+
+struct RangeSnapshot
+{
+  glm::vec2 value = {0.f, 0.f};
+  bool      is_active = true;
+};
+
+// Type-erased immutable value of an attribute, 'p_type' is the type of the value
+// returned by the attribute get_value() (EnumSnapshot and RangeSnapshot for Enum and
+// Range attributes).
+struct SnapshotEntry
+{
+  AttributeType               type = AttributeType::INVALID;
+  uint64_t                    version = 0;
+  std::shared_ptr<const void> p_value;
+  const std::type_info       *p_type = nullptr;
+};
+
+// =====================================
+// AttributesSnapshot
+// =====================================
+
+// Immutable copy of the values of a set of attributes, to be handed over to a worker
+// thread (typically a background evaluation): it does not reference the attributes, so
+// that later edits do not affect it. Values are typed, get<T> with T the type returned by
+// the attribute get_value() (float, std::string, hmap::Array...), except for Enum and
+// Range attributes (EnumSnapshot, RangeSnapshot).
+//
+// Large values (Array, Cloud, Path, ColorGradient) are not copied but shared with the
+// value published by the attribute (see AbstractAttribute::publish): snapshots of an
+// unchanged attribute share the same buffer, a copy is made only once the attribute has
+// been modified. Snapshots are built by the writer thread and then read from any thread.
+class AttributesSnapshot
+{
+public:
+  // Writer thread - Add the current value of the attribute, returns false if the key is
+  // already used or if the attribute type is not supported.
+  bool add(const std::string &key, AbstractAttribute *p_attr);
+
+  bool contains(const std::string &key) const;
+  bool empty() const;
+
+  // Nullptr if the key is missing or if T is not the value type.
+  template <typename T> const T *find(const std::string &key) const
+  {
+    auto it = this->entries.find(key);
+    if (it == this->entries.end() || *it->second.p_type != typeid(T))
+      return nullptr;
+
+    return static_cast<const T *>(it->second.p_value.get());
+  }
+
+  // Throw std::out_of_range if the key is missing, std::runtime_error if T is not the
+  // value type.
+  template <typename T> const T &get(const std::string &key) const
+  {
+    return *this->get_shared<T>(key);
+  }
+
+  // Shared ownership of the value, to keep it beyond the lifetime of the snapshot.
+  template <typename T> std::shared_ptr<const T> get_shared(const std::string &key) const
+  {
+    const SnapshotEntry &entry = this->entries.at(key);
+
+    if (*entry.p_type != typeid(T))
+    {
+      Logger::log()->critical("AttributesSnapshot::get: wrong value type for key {}, "
+                              "requested type is: [{}]",
+                              key,
+                              typeid(T).name());
+      throw std::runtime_error("wrong type");
+    }
+
+    return std::static_pointer_cast<const T>(entry.p_value);
+  }
+
+  std::vector<std::string> get_keys() const;
+
+  // Throw std::out_of_range if the key is missing.
+  AttributeType get_type(const std::string &key) const;
+  uint64_t      get_version(const std::string &key) const;
+
+  // Replace the value of a key by a value of the same type, typically to derive a
+  // variant from a copy of a snapshot (the other values remain shared). Returns false if
+  // the key is missing or if T is not the value type. The version of the entry becomes
+  // ATTR_SNAPSHOT_NO_VERSION.
+  template <typename T> bool set(const std::string &key, const T &value)
+  {
+    auto it = this->entries.find(key);
+
+    if (it == this->entries.end() || *it->second.p_type != typeid(T))
+    {
+      Logger::log()->error("AttributesSnapshot::set: no value of type [{}] for key {}",
+                           typeid(T).name(),
+                           key);
+      return false;
+    }
+
+    it->second.p_value = std::make_shared<const T>(value);
+    it->second.version = ATTR_SNAPSHOT_NO_VERSION;
+    return true;
+  }
+
+  size_t size() const;
+
+private:
+  std::map<std::string, SnapshotEntry> entries;
+};
+
+// Helper - Snapshot of the values of an attribute map, to be called from the writer
+// thread.
+std::shared_ptr<const AttributesSnapshot> snapshot_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map);
+
+} // namespace attr
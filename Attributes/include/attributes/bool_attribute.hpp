@@ -22,17 +22,19 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
-  std::string get_label_false() const;
-  std::string get_label_true() const;
-  bool        get_value() const;
-  void        set_value(const bool &new_value);
-  std::string to_string() override;
+  SharedString get_label_false() const;
+  SharedString get_label_true() const;
+  bool         get_value() const;
+  void         set_value(const bool &new_value);
+  std::string  to_string() override;
 
 private:
-  bool        value;
-  std::string label_true;
-  std::string label_false;
+  std::atomic<bool> value;
+  SharedString      label_true;
+  SharedString      label_false;
 };
 
 } // namespace attr
\ No newline at end of file
@@ -22,6 +22,8 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
   std::vector<std::string> get_choice_list() const;
   bool                     get_use_combo_list() const;
@@ -3,39 +3,106 @@
  * this software. */
 #pragma once
 #include <functional>
+#include <mutex>
+#include <span>
 
 #include <QImage>
 
 #include "highmap/geometry/cloud.hpp"
 
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/published_value.hpp"
 
 namespace attr
 {
 
+// =====================================
+// CloudBuffers
+// =====================================
+
+// Structure-of-arrays storage of a cloud: point coordinates and values.
+struct CloudBuffers
+{
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> v;
+};
+
 // =====================================
 // CloudAttribute
 // =====================================
 
+// The cloud is stored as x, y and value buffers (CloudBuffers) which can be read and
+// replaced without copy (get_buffers, get_x/get_y/get_values, set_buffers). The
+// hmap::Cloud value is only built when it is requested (get_value, get_value_ref,
+// edit_value, publish) and the buffers are rebuilt from it after it has been modified
+// through get_value_ref or edit_value. Both conversions are lazy and cached for the
+// current attribute version.
 class CloudAttribute : public AbstractAttribute
 {
 public:
   CloudAttribute(const std::string &label);
   CloudAttribute(const std::string &label, const hmap::Cloud &value);
 
-  std::function<QImage()> get_background_image_fct() const;
-  hmap::Cloud             get_value() const { return this->value; }
-  hmap::Cloud            *get_value_ref() { return &this->value; }
-  void                    set_background_image_fct(std::function<QImage()> new_fct);
-  void        set_value(const hmap::Cloud &new_value) { this->value = new_value; }
-  std::string to_string();
+  ValueWriteScope<hmap::Cloud> edit_value();
+  std::function<QImage()>      get_background_image_fct() const;
+  size_t                       get_npoints() const;
+  hmap::Cloud                  get_value() const;
+  // deprecated for writes, see edit_value
+  hmap::Cloud                 *get_value_ref();
+  void                         set_background_image_fct(std::function<QImage()> new_fct);
+  void                         set_value(const hmap::Cloud &new_value);
+  std::string                  to_string();
+
+  // Views on the buffers, invalidated by any modification of the attribute.
+  const CloudBuffers    &get_buffers() const;
+  std::span<const float> get_x() const;
+  std::span<const float> get_y() const;
+  std::span<const float> get_values() const;
+
+  // Take over the buffers (moved in), they must have the same size.
+  void set_buffers(std::vector<float> &&x,
+                   std::vector<float> &&y,
+                   std::vector<float> &&v);
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  void           json_write(std::ostream &os) const override;
+
+  std::vector<std::string> json_bulk_keys() const override;
+  void                     json_from_bulk(nlohmann::json const &json,
+                                          BulkArrays           &bulk) override;
+  nlohmann::json           json_to_bulk(BulkArrays &bulk) const override;
+  uint64_t                 hash() const override;
+  MemoryUsage              memory_usage() const override;
+
+  // Reader threads, see AbstractAttribute::publish.
+  std::shared_ptr<const hmap::Cloud> get_snapshot() const;
+  void                               publish() override;
 
 private:
-  hmap::Cloud             value;
+  // The hmap::Cloud value becomes the primary representation (before a write).
+  void make_value_primary();
+
+  // Rebuild the hmap::Cloud value, resp. the buffers, if it is outdated.
+  void sync_buffers() const;
+  void sync_value() const;
+
+  mutable CloudBuffers    buffers;
+  mutable hmap::Cloud     value;
   std::function<QImage()> background_image_fct = nullptr;
+
+  // One representation holds the value (the hmap::Cloud if 'is_value_primary', the
+  // buffers otherwise), the other one is a cache valid for the attribute version
+  // 'cache_version'. The caches are rebuilt by const readers, possibly concurrent,
+  // 'cache_mutex' guards them.
+  mutable std::mutex cache_mutex;
+  mutable uint64_t   cache_version = UINT64_MAX;
+  bool               is_value_primary = true;
+  uint64_t           value_ref_version = UINT64_MAX; // see get_value_ref
+
+  // snapshot for reader threads
+  PublishedValue<hmap::Cloud> published_value;
 };
 
 } // namespace attr
@@ -3,6 +3,7 @@
  * this software. */
 #pragma once
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/keyframe_track.hpp"
 
 namespace attr
 {
@@ -19,13 +20,31 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
   std::vector<float> get_value() const;
   void               set_value(const std::vector<float> &new_value);
   std::string        to_string();
 
+  // Animation, the static value is used while the track is empty. Batch evaluation
+  // writes the values of each time to 'out' (see KeyframeTrack::evaluate).
+  ValueWriteScope<KeyframeTrack> edit_track();
+  const KeyframeTrack           &get_track() const;
+  std::vector<float>             get_value_at(float time) const;
+  void                           get_values_at(std::span<const float> times,
+                                               float                 *out) const;
+
+protected:
+  void blend_value(const AbstractAttribute &a,
+                   const AbstractAttribute &b,
+                   float                    t) override;
+
 private:
   std::vector<float> value = {1.f, 1.f, 1.f, 1.f};
+
+  // animation
+  KeyframeTrack track;
 };
 
 } // namespace attr
\ No newline at end of file
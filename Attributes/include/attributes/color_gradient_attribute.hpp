@@ -5,6 +5,7 @@
 #include <array>
 
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/published_value.hpp"
 
 namespace attr
 {
@@ -41,18 +42,34 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
-  std::vector<Preset> get_presets() const;
-  std::vector<Stop>   get_value() const;
-  std::vector<Stop>  *get_value_ref();
-  void                set_presets(const std::vector<Preset> &new_presets);
-  void                set_value(const std::vector<Stop> &new_value);
-  void                shuffle_colors();
-  std::string         to_string();
+  ValueWriteScope<std::vector<Stop>> edit_value();
+  std::vector<Preset>                get_presets() const;
+  std::vector<Stop>                  get_value() const;
+  // deprecated for writes, see edit_value
+  std::vector<Stop>                 *get_value_ref();
+  void                               set_presets(const std::vector<Preset> &new_presets);
+  void                               set_value(const std::vector<Stop> &new_value);
+  void                               shuffle_colors();
+  std::string                        to_string();
+
+  // Reader threads, see AbstractAttribute::publish.
+  std::shared_ptr<const std::vector<Stop>> get_snapshot() const;
+  void                                     publish() override;
+
+protected:
+  void blend_value(const AbstractAttribute &a,
+                   const AbstractAttribute &b,
+                   float                    t) override;
 
 private:
   std::vector<Stop>   value = {{0.f, {0.f, 0.f, 0.f, 1.f}}, {1.f, {1.f, 1.f, 1.f, 1.f}}};
   std::vector<Preset> presets;
+
+  // snapshot for reader threads
+  PublishedValue<std::vector<Stop>> published_value;
 };
 
 } // namespace attr
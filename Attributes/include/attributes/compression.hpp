@@ -0,0 +1,60 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace attr
+{
+
+// Compression of the binary preset payloads (see PresetArchive). The codecs are
+// optional dependencies, available when the library is built with
+// ATTRIBUTES_ENABLE_COMPRESSION and the codec library is found (ATTR_HAS_LZ4,
+// ATTR_HAS_ZSTD).
+
+// DO NOT change the values, they are stored in the binary presets
+enum class CompressionCodec : uint32_t
+{
+  NONE = 0,
+  LZ4 = 1,  // fast
+  ZSTD = 2, // better ratio
+};
+
+// Reversible filters applied to float data before compression. SHUFFLE groups the
+// bytes of the floats by significance (exponents and high mantissa bytes of smooth data
+// are very redundant), DELTA_SHUFFLE first replaces each value bit pattern by its
+// difference with the previous one.
+enum class CompressionFilter : uint32_t
+{
+  NONE = 0,
+  SHUFFLE = 1,
+  DELTA_SHUFFLE = 2,
+};
+
+struct CompressionSettings
+{
+  CompressionCodec  codec = CompressionCodec::NONE;
+  CompressionFilter filter = CompressionFilter::DELTA_SHUFFLE;
+  int               level = 0; // 0 for the codec default
+};
+
+bool is_codec_available(CompressionCodec codec);
+
+// Compress 'n' floats into 'dst' (filter then codec). Returns false if the codec is not
+// available or fails.
+bool compress_floats(const CompressionSettings &settings,
+                     const float               *src,
+                     size_t                     n,
+                     std::vector<char>         &dst);
+
+// Decompress 'src_size' bytes into 'n' floats, 'codec' and 'filter' being the settings
+// used for compression. Returns false on corrupted data or unavailable codec.
+bool decompress_floats(CompressionCodec  codec,
+                       CompressionFilter filter,
+                       const char       *src,
+                       size_t            src_size,
+                       float            *dst,
+                       size_t            n);
+
+} // namespace attr
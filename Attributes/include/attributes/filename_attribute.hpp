@@ -23,6 +23,8 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
   std::string           get_filter() const;
   bool                  get_for_saving() const;
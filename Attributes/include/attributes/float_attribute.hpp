@@ -3,6 +3,8 @@
  * this software. */
 #pragma once
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/keyframe_track.hpp"
+#include "attributes/value_format.hpp"
 
 namespace attr
 {
@@ -23,21 +25,39 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
-  bool        get_log_scale() const;
-  float       get_value() const;
-  std::string get_value_format() const;
-  float       get_vmin() const;
-  float       get_vmax() const;
-  void        set_value(const float &new_value);
-  std::string to_string() override;
+  bool         get_log_scale() const;
+  float        get_value() const;
+  SharedString get_value_format() const;
+  float        get_vmin() const;
+  float        get_vmax() const;
+  void         set_value(const float &new_value);
+  std::string  to_string() override;
+
+  // Animation, the static value is used while the track is empty. Batch evaluation
+  // writes the values of each time to 'out' (see KeyframeTrack::evaluate).
+  ValueWriteScope<KeyframeTrack> edit_track();
+  const KeyframeTrack           &get_track() const;
+  float                          get_value_at(float time) const;
+  void                           get_values_at(std::span<const float> times,
+                                               float                 *out) const;
+
+protected:
+  void blend_value(const AbstractAttribute &a,
+                   const AbstractAttribute &b,
+                   float                    t) override;
 
 private:
-  float       value;
-  float       vmin;
-  float       vmax;
-  std::string value_format;
-  bool        log_scale;
+  std::atomic<float> value;
+  float              vmin;
+  float              vmax;
+  ValueFormat<float> value_format;
+  bool               log_scale;
+
+  // animation
+  KeyframeTrack track = KeyframeTrack(1);
 };
 
 } // namespace attr
@@ -0,0 +1,140 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace attr
+{
+
+// 64-bit digest helpers used to fingerprint attribute values (see
+// AbstractAttribute::hash). The byte hash follows the XXH64 algorithm: the main loop
+// feeds four independent accumulators so that large float buffers are processed at
+// memory bandwidth. Digests are stable across runs on a given platform (byte order
+// dependent).
+
+#define ATTR_HASH_P1 0x9E3779B185EBCA87ULL
+#define ATTR_HASH_P2 0xC2B2AE3D27D4EB4FULL
+#define ATTR_HASH_P3 0x165667B19E3779F9ULL
+#define ATTR_HASH_P4 0x85EBCA77C2B2AE63ULL
+#define ATTR_HASH_P5 0x27D4EB2F165667C5ULL
+
+// Helper - XXH64 accumulator round.
+inline uint64_t hash_round(uint64_t acc, uint64_t input)
+{
+  acc += input * ATTR_HASH_P2;
+  acc = std::rotl(acc, 31);
+  return acc * ATTR_HASH_P1;
+}
+
+// Helper - Final avalanche, spreads every input bit over the whole digest.
+inline uint64_t hash_mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= ATTR_HASH_P2;
+  h ^= h >> 29;
+  h *= ATTR_HASH_P3;
+  h ^= h >> 32;
+  return h;
+}
+
+// Helper - Combine a digest into a running seed (order dependent).
+inline uint64_t hash_combine(uint64_t seed, uint64_t h)
+{
+  return hash_mix(hash_round(seed, h) + ATTR_HASH_P4);
+}
+
+// Helper - Digest of a raw byte buffer.
+inline uint64_t hash_bytes(const void *data, size_t n, uint64_t seed = 0)
+{
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  const unsigned char *end = p + n;
+
+  auto read64 = [](const unsigned char *ptr)
+  {
+    uint64_t v;
+    std::memcpy(&v, ptr, sizeof(v));
+    return v;
+  };
+
+  uint64_t h;
+
+  if (n >= 32)
+  {
+    uint64_t v1 = seed + ATTR_HASH_P1 + ATTR_HASH_P2;
+    uint64_t v2 = seed + ATTR_HASH_P2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - ATTR_HASH_P1;
+
+    const unsigned char *limit = end - 32;
+    do
+    {
+      v1 = hash_round(v1, read64(p));
+      v2 = hash_round(v2, read64(p + 8));
+      v3 = hash_round(v3, read64(p + 16));
+      v4 = hash_round(v4, read64(p + 24));
+      p += 32;
+    } while (p <= limit);
+
+    h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+
+    for (uint64_t v : {v1, v2, v3, v4})
+    {
+      h ^= hash_round(0, v);
+      h = h * ATTR_HASH_P1 + ATTR_HASH_P4;
+    }
+  }
+  else
+    h = seed + ATTR_HASH_P5;
+
+  h += (uint64_t)n;
+
+  for (; p + 8 <= end; p += 8)
+  {
+    h ^= hash_round(0, read64(p));
+    h = std::rotl(h, 27) * ATTR_HASH_P1 + ATTR_HASH_P4;
+  }
+
+  if (p + 4 <= end)
+  {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    h ^= (uint64_t)v * ATTR_HASH_P1;
+    h = std::rotl(h, 23) * ATTR_HASH_P2 + ATTR_HASH_P3;
+    p += 4;
+  }
+
+  for (; p < end; ++p)
+  {
+    h ^= (uint64_t)(*p) * ATTR_HASH_P5;
+    h = std::rotl(h, 11) * ATTR_HASH_P1;
+  }
+
+  return hash_mix(h);
+}
+
+// Helper - Digest of a contiguous buffer of trivially copyable values (floats, ints...).
+template <typename T> inline uint64_t hash_vector(const std::vector<T> &v)
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+  return hash_bytes(v.data(), v.size() * sizeof(T));
+}
+
+inline uint64_t hash_string(const std::string &s)
+{
+  return hash_bytes(s.data(), s.size());
+}
+
+// Helper - Digest of a single trivially copyable value.
+template <typename T> inline uint64_t hash_value(const T &v)
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+  return hash_bytes(&v, sizeof(T));
+}
+
+} // namespace attr
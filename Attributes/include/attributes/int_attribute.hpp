@@ -3,6 +3,7 @@
  * this software. */
 #pragma once
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/value_format.hpp"
 
 namespace attr
 {
@@ -22,19 +23,26 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
-  int         get_value() const;
-  std::string get_value_format() const;
-  int         get_vmin() const;
-  int         get_vmax() const;
-  void        set_value(const int &new_value);
-  std::string to_string() override;
+  int          get_value() const;
+  SharedString get_value_format() const;
+  int          get_vmin() const;
+  int          get_vmax() const;
+  void         set_value(const int &new_value);
+  std::string  to_string() override;
+
+protected:
+  void blend_value(const AbstractAttribute &a,
+                   const AbstractAttribute &b,
+                   float                    t) override;
 
 private:
-  int         value;
-  int         vmin;
-  int         vmax;
-  std::string value_format;
+  std::atomic<int> value;
+  int              vmin;
+  int              vmax;
+  ValueFormat<int> value_format;
 };
 
 } // namespace attr
@@ -0,0 +1,262 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "attributes/abstract_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/logger.hpp"
+#include "nlohmann/json.hpp"
+
+namespace attr
+{
+
+// The fields found while reading an object are tracked with a 64-bit mask
+#define ATTR_JSON_SCHEMA_MAX_FIELDS 64
+
+// Helper - Assign a JSON value to a member, throws a nlohmann::json::exception if the
+// value cannot be converted.
+template <typename V> void json_get_value(const nlohmann::json &j, V &value)
+{
+  j.get_to(value);
+}
+
+template <typename V> void json_get_value(const nlohmann::json &j, std::atomic<V> &value)
+{
+  value.store(j.get<V>());
+}
+
+inline void json_get_value(const nlohmann::json &j, glm::vec2 &value)
+{
+  std::array<float, 2> raw = j.get<std::array<float, 2>>();
+  value = {raw[0], raw[1]};
+}
+
+// Helper - Float array, null elements (NaNs serialized by nlohmann::json) are read as
+// NaNs.
+inline void json_get_value(const nlohmann::json &j, std::vector<float> &value)
+{
+  // throws if not an array
+  const auto &array = j.get_ref<const nlohmann::json::array_t &>();
+
+  value.clear();
+  value.reserve(array.size());
+
+  for (auto &v : array)
+    value.push_back(v.is_null() ? std::nanf("") : v.get<float>());
+}
+
+// =====================================
+// JsonSchema
+// =====================================
+
+// Static description of the JSON serialization of a type: the field keys and the
+// setters writing them to an instance. The keys are dispatched through a perfect hash
+// table built once, so that an object is deserialized in a single pass over its members
+// (one hash and one string comparison per member). For attributes the "type" and
+// "label" fields of AbstractAttribute are added to the schema.
+//
+// Schemas are meant to be function-local statics of the json_from implementations:
+//
+// static const JsonSchema<FloatAttribute> schema = {
+//     JsonSchema<FloatAttribute>::member<&FloatAttribute::value>("value"),
+//     ...};
+template <class T> class JsonSchema
+{
+public:
+  using Setter = void (*)(T &target, const nlohmann::json &j);
+
+  struct Field
+  {
+    std::string_view key;
+    Setter           setter = nullptr; // nullptr for a bulk array, see bulk()
+    bool             is_required = true;
+  };
+
+  JsonSchema(std::initializer_list<Field> new_fields = {});
+
+  // Field of a bulk float array (see AbstractAttribute::json_bulk_keys), read into the
+  // 'p_bulk' argument of read. It is optional since the streaming preset loader provides
+  // the bulk arrays apart from the JSON object.
+  static Field bulk(std::string_view key) { return {key, nullptr, false}; }
+
+  // Field assigned to the member M (see json_get_value).
+  template <auto M> static Field member(std::string_view key, bool is_required = true)
+  {
+    return {key,
+            [](T &target, const nlohmann::json &j) { json_get_value(j, target.*M); },
+            is_required};
+  }
+
+  // Deserialize the object 'json' into 'target'. Unknown keys are ignored, values which
+  // cannot be converted are skipped. Errors (not an object, missing required key,
+  // invalid value) are logged with the attribute type and label, read then returns
+  // false.
+  bool read(const nlohmann::json &json, T &target, BulkArrays *p_bulk = nullptr) const;
+
+private:
+  std::string error_context(const T &target) const;
+  int         find(std::string_view key) const;
+  uint64_t    hash_key(std::string_view key) const;
+
+  std::vector<Field>  fields;
+  std::vector<int8_t> table; // field index, -1 for an empty slot
+  uint64_t            seed = 0;
+  uint64_t            required_mask = 0;
+};
+
+// class definition
+
+template <class T> JsonSchema<T>::JsonSchema(std::initializer_list<Field> new_fields)
+{
+  if constexpr (std::is_base_of_v<AbstractAttribute, T>)
+  {
+    this->fields.push_back(
+        {"type",
+         [](T &target, const nlohmann::json &j)
+         { json_get_value(j, static_cast<AbstractAttribute &>(target).type); }});
+    this->fields.push_back(
+        {"label",
+         [](T &target, const nlohmann::json &j)
+         { json_get_value(j, static_cast<AbstractAttribute &>(target).label); }});
+  }
+
+  this->fields.insert(this->fields.end(), new_fields.begin(), new_fields.end());
+
+  if (this->fields.size() > ATTR_JSON_SCHEMA_MAX_FIELDS)
+    throw std::length_error("JsonSchema: too many fields");
+
+  for (size_t k = 0; k < this->fields.size(); k++)
+    if (this->fields[k].is_required)
+      this->required_mask |= uint64_t(1) << k;
+
+  // search a seed without collision, the table being grown every few hundred tries
+  size_t size = std::bit_ceil(std::max(size_t(2), 2 * this->fields.size()));
+
+  for (uint64_t tries = 0;; tries++)
+  {
+    if (tries > 0 && tries % 256 == 0)
+      size *= 2;
+
+    this->seed = tries;
+    this->table.assign(size, -1);
+
+    bool is_perfect = true;
+
+    for (size_t k = 0; k < this->fields.size() && is_perfect; k++)
+    {
+      int8_t &slot = this->table[this->hash_key(this->fields[k].key) & (size - 1)];
+
+      if (slot >= 0)
+      {
+        // a duplicated key would never be resolved
+        if (this->fields[slot].key == this->fields[k].key)
+          throw std::invalid_argument("JsonSchema: duplicated key");
+        is_perfect = false;
+      }
+      else
+        slot = static_cast<int8_t>(k);
+    }
+
+    if (is_perfect)
+      break;
+  }
+}
+
+template <class T> std::string JsonSchema<T>::error_context(const T &target) const
+{
+  if constexpr (std::is_base_of_v<AbstractAttribute, T>)
+    return target.get_type_string() + " attribute \"" + target.get_label().str() + "\"";
+  else
+    return "JsonSchema";
+}
+
+template <class T> int JsonSchema<T>::find(std::string_view key) const
+{
+  int k = this->table[this->hash_key(key) & (this->table.size() - 1)];
+  return (k >= 0 && this->fields[k].key == key) ? k : -1;
+}
+
+template <class T> uint64_t JsonSchema<T>::hash_key(std::string_view key) const
+{
+  // FNV-1a, the keys are short
+  uint64_t h = 0xCBF29CE484222325ULL ^ hash_mix(this->seed);
+
+  for (char c : key)
+  {
+    h ^= static_cast<unsigned char>(c);
+    h *= 0x100000001B3ULL;
+  }
+
+  return hash_mix(h);
+}
+
+template <class T>
+bool JsonSchema<T>::read(const nlohmann::json &json, T &target, BulkArrays *p_bulk) const
+{
+  if (!json.is_object())
+  {
+    Logger::log()->error("{}: json object expected, got {}",
+                         this->error_context(target),
+                         json.type_name());
+    return false;
+  }
+
+  bool     ret = true;
+  uint64_t found_mask = 0;
+
+  for (auto it = json.begin(); it != json.end(); ++it)
+  {
+    int k = this->find(it.key());
+
+    if (k < 0)
+      continue;
+
+    const Field &field = this->fields[k];
+    found_mask |= uint64_t(1) << k;
+
+    try
+    {
+      if (field.setter)
+        field.setter(target, it.value());
+      else if (p_bulk)
+        json_get_value(it.value(), (*p_bulk)[std::string(field.key)]);
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+      Logger::log()->error("{}: invalid value for json key \"{}\" ({})",
+                           this->error_context(target),
+                           field.key,
+                           e.what());
+      ret = false;
+    }
+  }
+
+  uint64_t missing_mask = this->required_mask & ~found_mask;
+
+  for (; missing_mask; missing_mask &= missing_mask - 1)
+  {
+    Logger::log()->error("{}: required json key \"{}\" not found",
+                         this->error_context(target),
+                         this->fields[std::countr_zero(missing_mask)].key);
+    ret = false;
+  }
+
+  return ret;
+}
+
+} // namespace attr
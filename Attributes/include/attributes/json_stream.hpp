@@ -0,0 +1,70 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <ostream>
+
+#include "nlohmann/json.hpp"
+
+namespace attr
+{
+
+// Helpers used to write large attribute payloads straight to an output stream as
+// compact JSON, without building the intermediate nlohmann::json tree (which costs
+// about 16 bytes per float).
+
+#define ATTR_JSON_STREAM_BUFFER_SIZE 4096
+
+// Helper - Write the members of a JSON object without its closing brace, so that the
+// caller can append more members (starting with a comma) and close the object.
+inline void json_write_head(std::ostream &os, const nlohmann::json &head)
+{
+  std::string str = head.dump();
+  str.pop_back(); // '}'
+  os << str;
+}
+
+// Helper - Write 'n' floats as a JSON array, 'fct(k)' returning the k-th value. Values
+// use the shortest round-trip representation, non-finite values are written as null
+// (as nlohmann does). Memory usage is bounded by a fixed size buffer.
+template <typename F> void json_write_float_array(std::ostream &os, size_t n, F &&fct)
+{
+  char   buffer[ATTR_JSON_STREAM_BUFFER_SIZE];
+  size_t pos = 0;
+
+  buffer[pos++] = '[';
+
+  for (size_t k = 0; k < n; ++k)
+  {
+    // largest float representation is well below 32 characters
+    if (pos + 32 > ATTR_JSON_STREAM_BUFFER_SIZE)
+    {
+      os.write(buffer, pos);
+      pos = 0;
+    }
+
+    if (k > 0)
+      buffer[pos++] = ',';
+
+    float v = fct(k);
+
+    if (std::isfinite(v))
+    {
+      auto res = std::to_chars(buffer + pos, buffer + ATTR_JSON_STREAM_BUFFER_SIZE, v);
+      pos = res.ptr - buffer;
+    }
+    else
+    {
+      std::memcpy(buffer + pos, "null", 4);
+      pos += 4;
+    }
+  }
+
+  buffer[pos++] = ']';
+  os.write(buffer, pos);
+}
+
+} // namespace attr
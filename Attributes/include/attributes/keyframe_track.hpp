@@ -0,0 +1,85 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace attr
+{
+
+// Batch evaluation works on blocks of times, with the segment lookup results kept on
+// the stack
+#define ATTR_KEYFRAME_BLOCK_SIZE 256
+
+// DO NOT change the values, they are serialized
+enum class KeyframeInterpolation : int
+{
+  STEP = 0,   // value of the previous key
+  LINEAR = 1, //
+  CUBIC = 2,  // Catmull-Rom spline (tangents from the neighboring keys)
+};
+
+// =====================================
+// KeyframeTrack
+// =====================================
+
+// Animation of a value made of 'ncomponents' floats (1 for a float, 2 for a vec2...):
+// keys sorted by time, values stored contiguously (ncomponents per key), and one
+// interpolation mode for the whole track. Before the first key and after the last one
+// the value is held.
+class KeyframeTrack
+{
+public:
+  explicit KeyframeTrack(
+      size_t                ncomponents = 1,
+      KeyframeInterpolation interpolation = KeyframeInterpolation::LINEAR);
+
+  void clear();
+  bool empty() const;
+
+  // Value at 'time', ncomponents values written to 'out'. 'static_value' is used if the
+  // track is empty.
+  void evaluate(float time, float *out, const float *static_value = nullptr) const;
+
+  // Batch - values at each time, 'out' receives times.size() * ncomponents values
+  // (interleaved). Sorted times, e.g. the frames of a sequence, are evaluated in a single
+  // pass over the keys.
+  void evaluate(std::span<const float> times,
+                float                 *out,
+                const float           *static_value = nullptr) const;
+
+  KeyframeInterpolation     get_interpolation() const;
+  size_t                    get_ncomponents() const;
+  size_t                    get_nkeys() const;
+  const std::vector<float> &get_times() const;
+  const std::vector<float> &get_values() const;
+  uint64_t                  hash() const;
+  void                      json_from(nlohmann::json const &json);
+  nlohmann::json            json_to() const;
+  size_t                    memory_usage() const; // heap memory, in bytes
+  void                      remove_key(size_t index);
+  void                      set_interpolation(KeyframeInterpolation new_interpolation);
+
+  // Add a key, ncomponents values read from 'value'. A key at the same time is replaced.
+  void set_key(float time, const float *value);
+
+private:
+  // Index k of the segment [times[k], times[k + 1]] containing 'time', starting the
+  // search from 'k_start' if the previous time was smaller.
+  size_t find_segment(float time, size_t k_start) const;
+
+  // Catmull-Rom tangents, updated each time the keys change.
+  void update_tangents();
+
+  size_t                ncomponents;
+  KeyframeInterpolation interpolation;
+  std::vector<float>    times;
+  std::vector<float>    values;
+  std::vector<float>    tangents;
+};
+
+} // namespace attr
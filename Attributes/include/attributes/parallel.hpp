@@ -0,0 +1,54 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace attr
+{
+
+// Below this number of elements per worker, work is not split any further (spawning
+// threads is more expensive than scanning a few thousand floats)
+#define ATTR_PARALLEL_MIN_CHUNK 65536
+
+// Helper - Number of chunks used to process 'n' elements in parallel.
+inline size_t parallel_chunk_count(size_t n)
+{
+  size_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+  size_t nchunks = std::max(size_t(1), n / ATTR_PARALLEL_MIN_CHUNK);
+  return std::min(nthreads, nchunks);
+}
+
+// Helper - Split the range [0, n) into 'nchunks' contiguous chunks and call
+// 'fct(chunk_index, begin, end)' for each of them, one thread per chunk. The first chunk
+// is processed on the calling thread. Returns once all the chunks are done.
+template <typename F> void parallel_for_chunks(size_t n, size_t nchunks, F &&fct)
+{
+  if (nchunks <= 1 || n == 0)
+  {
+    fct(size_t(0), size_t(0), n);
+    return;
+  }
+
+  size_t chunk_size = (n + nchunks - 1) / nchunks;
+
+  std::vector<std::thread> threads;
+  threads.reserve(nchunks - 1);
+
+  for (size_t k = 1; k < nchunks; ++k)
+  {
+    size_t begin = std::min(n, k * chunk_size);
+    size_t end = std::min(n, begin + chunk_size);
+    threads.emplace_back([&fct, k, begin, end]() { fct(k, begin, end); });
+  }
+
+  fct(size_t(0), size_t(0), std::min(n, chunk_size));
+
+  for (auto &t : threads)
+    t.join();
+}
+
+} // namespace attr
@@ -0,0 +1,112 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "attributes/abstract_attribute.hpp"
+#include "attributes/attributes_snapshot.hpp"
+
+namespace attr
+{
+
+// Number of Sobol dimensions with tabulated direction numbers, further dimensions are
+// sampled randomly
+#define ATTR_SWEEP_SOBOL_MAX_DIM 16
+
+enum class SweepSampling
+{
+  GRID,   // every combination of 'nsteps' regularly spaced values per axis
+  RANDOM, // 'nsamples' uniform random draws
+  SOBOL,  // 'nsamples' points of a Sobol low-discrepancy sequence
+};
+
+// Swept attribute, Float, Int, Range or Seed. Values are taken in the attribute bounds
+// [vmin, vmax] unless 'bounds' is given (reversed bounds are swapped, seed bounds are
+// clamped to the unsigned 32-bit range). Seeds have no bounds: by default the grid uses
+// consecutive seeds from the current one and the other samplings any seed. Both ends of
+// a range are sampled (sorted), the grid then enumerates the pairs low <= high.
+struct SweepAxis
+{
+  std::string              key;
+  int                      nsteps = 3; // grid only
+  std::optional<glm::vec2> bounds = std::nullopt;
+};
+
+// =====================================
+// ParameterSweep
+// =====================================
+
+// Lazy generator of variants of an attribute map. The sweep is set up from the map on
+// the writer thread, it then only holds an immutable snapshot of the map (see
+// AttributesSnapshot): variants are computed on request from their index, share every
+// value but the swept ones with the base snapshot, and can be requested from any thread.
+class ParameterSweep
+{
+public:
+  ParameterSweep(
+      const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+      const std::vector<SweepAxis>                                    &axes,
+      SweepSampling sampling = SweepSampling::GRID,
+      size_t        nsamples = 0, // random and Sobol only
+      uint64_t      seed = 0);    // random only
+
+  std::shared_ptr<const AttributesSnapshot> get_base() const;
+
+  // Throw std::out_of_range if 'index' is not in [0, size()).
+  std::shared_ptr<const AttributesSnapshot> get_variant(size_t index) const;
+
+  // Variant values of the swept keys as text, e.g. for a file name or a caption.
+  std::string get_variant_description(size_t index) const;
+
+  // Shared iteration: each call returns the next variant not handed out yet (in any
+  // thread), nullptr once they all have been. 'p_index' receives the variant index.
+  std::shared_ptr<const AttributesSnapshot> next(size_t *p_index = nullptr);
+
+  // Start the shared iteration over.
+  void reset();
+
+  size_t size() const;
+
+private:
+  struct Axis
+  {
+    std::string   key;
+    AttributeType type;
+    float         vmin;
+    float         vmax;
+    int           nsteps;
+    uint32_t      seed_start; // seed grid without bounds
+    bool          has_bounds;
+    size_t        dim; // index of the first sampling dimension of the axis
+  };
+
+  // Grid - number of values of an axis.
+  size_t get_grid_count(const Axis &axis) const;
+
+  // Value in [0, 1) of sampling dimension 'dim' for the variant (random and Sobol).
+  float get_sample(size_t index, size_t dim) const;
+
+  // Set the value of the axis in 'snapshot', 'u' holds the coordinates in [0, 1] of
+  // the axis dimensions (2 for ranges). 'grid_index' is used instead for grid sampling.
+  void set_axis_value(AttributesSnapshot &snapshot,
+                      const Axis         &axis,
+                      const float        *u,
+                      size_t              grid_index) const;
+
+  std::shared_ptr<const AttributesSnapshot> base;
+  std::vector<Axis>                         axes;
+  SweepSampling                             sampling;
+  size_t                                    nvariants = 0;
+  size_t                                    ndims = 0;
+  uint64_t                                  seed;
+  std::atomic<size_t>                       next_index = 0;
+};
+
+} // namespace attr
@@ -5,6 +5,7 @@
 #include "highmap/geometry/path.hpp"
 
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/published_value.hpp"
 
 namespace attr
 {
@@ -21,14 +22,38 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
-
-  hmap::Path  get_value() const;
-  hmap::Path *get_value_ref();
-  void        set_value(const hmap::Path &new_value);
-  std::string to_string() override;
+  void           json_write(std::ostream &os) const override;
+
+  std::vector<std::string> json_bulk_keys() const override;
+  void                     json_from_bulk(nlohmann::json const &json,
+                                          BulkArrays           &bulk) override;
+  nlohmann::json           json_to_bulk(BulkArrays &bulk) const override;
+  uint64_t                 hash() const override;
+  MemoryUsage              memory_usage() const override;
+
+  ValueWriteScope<hmap::Path> edit_value();
+  hmap::Path                  get_value() const;
+  const hmap::Path           &get_value_cref() const; // read-only, writer thread
+  // deprecated for writes, see edit_value
+  hmap::Path                 *get_value_ref();
+  void                        set_value(const hmap::Path &new_value);
+  std::string                 to_string() override;
+
+  // Replace the points by the x, y, value buffers (e.g. from import_points), they must
+  // have the same size. The path remains closed or open.
+  void set_buffers(std::vector<float> &&x,
+                   std::vector<float> &&y,
+                   std::vector<float> &&v);
+
+  // Reader threads, see AbstractAttribute::publish.
+  std::shared_ptr<const hmap::Path> get_snapshot() const;
+  void                              publish() override;
 
 private:
   hmap::Path value;
+
+  // snapshot for reader threads
+  PublishedValue<hmap::Path> published_value;
 };
 
 } // namespace attr
@@ -0,0 +1,45 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "attributes/cloud_attribute.hpp" // CloudBuffers
+
+namespace attr
+{
+
+// Point files are imported into x, y, value buffers (CloudBuffers), which are then
+// handed over to a CloudAttribute or a PathAttribute with set_buffers. The import does
+// not touch any attribute and can run on a worker thread.
+//
+// Formats:
+// - CSV: one point per line, 'x y [value]' separated by commas, semicolons, spaces or
+//   tabs (value defaults to 0). Empty lines, '#' comments and a header line before the
+//   first point are skipped.
+// - binary (".bin" extension): raw float32 records (x, y, value), native byte order.
+
+// Number of bytes parsed between two calls of the progress function
+#define ATTR_IMPORT_PROGRESS_STEP 1048576
+
+// Called with the fraction of the file parsed, in [0, 1]. Returning false cancels the
+// import.
+using PointImportProgressFct = std::function<bool(float progress)>;
+
+// Import the file (memory-mapped) into 'buffers'. Returns false on error or if the
+// import is canceled, 'buffers' is then left unchanged.
+bool import_points(const std::string     &fname,
+                   CloudBuffers          &buffers,
+                   PointImportProgressFct progress_fct = nullptr);
+
+bool import_points_binary(std::string_view       data,
+                          CloudBuffers          &buffers,
+                          PointImportProgressFct progress_fct = nullptr);
+
+bool import_points_csv(std::string_view       data,
+                       CloudBuffers          &buffers,
+                       PointImportProgressFct progress_fct = nullptr);
+
+} // namespace attr
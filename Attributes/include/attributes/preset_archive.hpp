@@ -0,0 +1,140 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "attributes/abstract_attribute.hpp"
+#include "attributes/compression.hpp"
+
+namespace attr
+{
+
+// Binary preset container. Layout (native byte order, checked when opening):
+//
+// - header: magic, format version, byte order mark, index offset and size, number of
+//   entries (padded to 64 bytes),
+// - payloads, each one starting on a 64-byte boundary: for every attribute the compact
+//   JSON state without its bulk members (see AbstractAttribute::json_to_bulk), then the
+//   float data of each bulk member, raw or compressed (see compression.hpp),
+// - index: for every key, the attribute type and the offset/length of its payloads.
+//
+// The index is written last so that attributes can be streamed to the file one at a
+// time, the header gives its location.
+
+#define ATTR_ARCHIVE_ALIGNMENT 64
+#define ATTR_ARCHIVE_VERSION 2
+
+// Upper bounds on the decompressed size of a bulk member, checked when the index is
+// read so that a corrupted count cannot trigger a huge allocation: a fixed limit (1 GiB
+// of floats) and, for LZ4, the maximum compression ratio of the format
+#define ATTR_ARCHIVE_MAX_BULK_COUNT (uint64_t(1) << 28)
+#define ATTR_ARCHIVE_LZ4_MAX_RATIO 255
+
+// =====================================
+// PresetArchiveEntry
+// =====================================
+
+struct PresetArchiveBulk
+{
+  std::string       name;
+  uint64_t          offset; // in bytes
+  uint64_t          count;  // number of floats
+  CompressionCodec  codec = CompressionCodec::NONE;
+  CompressionFilter filter = CompressionFilter::NONE;
+  uint64_t          size = 0; // stored size in bytes
+};
+
+struct PresetArchiveEntry
+{
+  AttributeType                  type = AttributeType::INVALID;
+  uint64_t                       json_offset = 0;
+  uint64_t                       json_length = 0;
+  std::vector<PresetArchiveBulk> bulk;
+};
+
+// =====================================
+// PresetArchive
+// =====================================
+
+// Read access to a binary preset. The file is memory-mapped and only the index is read
+// when opening it, attribute payloads are decoded on demand. Uncompressed bulk float
+// data are copied once from the mapping into the attribute (hmap::Array owns its
+// buffer, so a true zero-copy load is not possible), without any text parsing.
+class PresetArchive
+{
+public:
+  PresetArchive() = default;
+  PresetArchive(const std::string &fname);
+  ~PresetArchive();
+
+  PresetArchive(const PresetArchive &) = delete;
+  PresetArchive &operator=(const PresetArchive &) = delete;
+
+  void close();
+  bool contains(const std::string &key) const;
+
+  // Full JSON state of an attribute, as it would appear in a JSON preset.
+  nlohmann::json get_json(const std::string &key) const;
+
+  std::vector<std::string> get_keys() const;
+  AttributeType            get_type(const std::string &key) const;
+  bool                     is_open() const;
+
+  // Write the full JSON state of an attribute to a stream, bulk data are streamed from
+  // the mapping.
+  bool json_write(const std::string &key, std::ostream &os) const;
+
+  // Load the attribute 'key' into 'p_attr', returns false if the key is missing or if
+  // the types do not match.
+  bool load(const std::string &key, AbstractAttribute *p_attr) const;
+
+  // Load every attribute of the map found in the archive, returns false if any of them
+  // could not be loaded.
+  bool load(std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map) const;
+
+  bool open(const std::string &fname);
+
+private:
+  bool read_bulk(const PresetArchiveBulk &b, std::vector<float> &vec) const;
+  bool read_index();
+
+  std::string                               fname;
+  const char                               *data = nullptr;
+  size_t                                    size = 0;
+  bool                                      is_mapped = false;
+  std::vector<char>                         buffer; // fallback when mmap is unavailable
+  std::map<std::string, PresetArchiveEntry> index;
+};
+
+// Write the attribute map to a binary preset, one attribute at a time. The bulk float
+// data are compressed according to 'compression', which can be overridden per attribute
+// key with 'key_compression'. Unavailable codecs fall back to no compression.
+bool save_preset_archive(
+    const std::string                                               &fname,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+    const CompressionSettings                                       &compression = {},
+    const std::map<std::string, CompressionSettings> &key_compression = {});
+
+// Write a preset given as a JSON object {key: attribute state, ...}, e.g. a parsed JSON
+// preset, to a binary preset (no attribute map needed).
+bool save_preset_archive_json(const std::string         &fname,
+                              nlohmann::json             preset,
+                              const CompressionSettings &compression = {});
+
+// Bulk members of the attributes of a given type (mirrors the json_bulk_keys overrides),
+// used when the attribute instances are not at hand.
+std::vector<std::string> archive_bulk_keys(AttributeType type);
+
+// Conversions between JSON presets and binary presets (no attribute map needed).
+bool preset_archive_to_json(const std::string &archive_fname,
+                            const std::string &json_fname);
+bool preset_json_to_archive(const std::string         &json_fname,
+                            const std::string         &archive_fname,
+                            const CompressionSettings &compression = {});
+
+} // namespace attr
@@ -0,0 +1,52 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <functional>
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "attributes/abstract_attribute.hpp"
+
+namespace attr
+{
+
+// Presets are JSON objects {key: attribute state, ...}, the attribute state being the
+// output of AbstractAttribute::json_to.
+
+// Load a JSON preset into the attribute map. The input is parsed as a stream of SAX
+// events dispatched to the attributes: the large float arrays (see
+// AbstractAttribute::json_bulk_keys) are parsed straight into typed buffers and no JSON
+// tree is built for them. Attributes whose key is missing in the preset, or with a
+// different type, are left untouched. 'post_load_fct' is called with the key of each
+// attribute loaded. Returns false if the input is not valid JSON (the attributes
+// parsed before the error are loaded).
+bool read_preset(
+    std::istream                                              &is,
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+    std::function<void(const std::string &)>                   post_load_fct = nullptr);
+
+// Load a preset file, see read_preset. An error is logged for every attribute not found
+// in the preset.
+bool load_preset(
+    const std::string                                         &fname,
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+    std::function<void(const std::string &)>                   post_load_fct = nullptr);
+
+// Write the attribute map as a compact JSON preset. Attributes are serialized one at a
+// time straight to the stream (see AbstractAttribute::json_write) so that the memory
+// overhead does not scale with the total payload size.
+void write_preset(
+    std::ostream                                                    &os,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map);
+
+// Write the attribute map to a preset file, returns false if the file could not be
+// written.
+bool save_preset(
+    const std::string                                               &fname,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map);
+
+} // namespace attr
@@ -0,0 +1,80 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "attributes/abstract_attribute.hpp"
+
+namespace attr
+{
+
+// Incremental preset saving. The journal file is a sequence of records, one per line,
+// each record being a compact JSON preset {key: attribute state, ...}. Replaying the
+// records in order gives the current state of the attributes.
+//
+// The journal remembers the version counter of each attribute as last written (see
+// AbstractAttribute::get_version), so that a save only appends the attributes modified
+// since, and its cost is proportional to the edit rather than to the size of the map.
+// The journal is compacted (rewritten as a single record holding every attribute) when
+// it holds too many records or when the appended records outweigh a full rewrite.
+
+#define ATTR_JOURNAL_MAX_RECORDS 64
+
+// =====================================
+// PresetJournal
+// =====================================
+
+class PresetJournal
+{
+public:
+  PresetJournal() = delete;
+  PresetJournal(const std::string &fname, size_t max_records = ATTR_JOURNAL_MAX_RECORDS);
+
+  // Rewrite the journal as a single record holding every attribute of the map. The
+  // file is written aside and then renamed so that an interrupted compaction does not
+  // lose the previous journal.
+  bool compact(const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map);
+
+  std::vector<std::string> get_dirty_keys(
+      const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map) const;
+
+  std::string get_fname() const;
+  size_t      get_record_count() const;
+
+  // Replay the journal into the attribute map, the attributes loaded are then
+  // considered as saved. A truncated last record (interrupted append) is ignored and
+  // the next save compacts the journal. Returns false if the file could not be read.
+  bool load(std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+            std::function<void(const std::string &)> post_load_fct = nullptr);
+
+  // Append a record with the attributes modified since the last save, or compact the
+  // journal if required. The first save of a journal which has not been loaded is a
+  // compaction (the previous content of the file is discarded).
+  bool save(const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map);
+
+private:
+  struct SavedState
+  {
+    const AbstractAttribute *p_attr = nullptr;
+    uint64_t                 version = 0;
+  };
+
+  bool is_dirty(const std::string &key, const AbstractAttribute *p_attr) const;
+  void mark_saved(const std::string &key, const AbstractAttribute *p_attr);
+
+  std::string                       fname;
+  size_t                            max_records;
+  size_t                            record_count = 0;
+  bool                              needs_compaction = false;
+  size_t                            journal_size = 0;  // in bytes
+  size_t                            snapshot_size = 0; // size of the first record
+  std::map<std::string, SavedState> saved_states = {};
+};
+
+} // namespace attr
@@ -0,0 +1,101 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "attributes/abstract_attribute.hpp"
+
+namespace attr
+{
+
+// Arrays are compared by tiles of ATTR_PATCH_TILE_SIZE x ATTR_PATCH_TILE_SIZE values,
+// the tiles which changed are stored whole
+#define ATTR_PATCH_TILE_SIZE 32
+
+// Runs of changed values of the other float arrays (Cloud, Path) closer than this are
+// merged, a run costs more than a few values
+#define ATTR_PATCH_RUN_GAP 8
+
+#define ATTR_PATCH_VERSION 1
+
+// =====================================
+// PatchEntry
+// =====================================
+
+// Values of a bulk float array (see AbstractAttribute::json_bulk_keys): 'nrows' rows of
+// 'ncols' values starting at index 'start', 'stride' values apart. A run of consecutive
+// values is a single row.
+struct PatchBlock
+{
+  std::string        name;
+  uint64_t           start = 0;
+  uint64_t           nrows = 1;
+  uint64_t           ncols = 0;
+  uint64_t           stride = 0;
+  std::vector<float> values;
+};
+
+// Change of an attribute. Either the full state ('is_full', 'members' then holds the
+// whole JSON state without the bulk members, and 'blocks' the whole bulk arrays), or a
+// delta: the JSON members which changed, the changed elements of JSON arrays of
+// unchanged size ({member: [[index, element], ...]}, e.g. VecFloat, VecInt or
+// ColorGradient values) and the changed blocks of the bulk arrays.
+struct PatchEntry
+{
+  AttributeType           type = AttributeType::INVALID;
+  bool                    is_full = false;
+  nlohmann::json          members = nlohmann::json::object();
+  nlohmann::json          elements = nlohmann::json::object();
+  std::vector<PatchBlock> blocks;
+};
+
+// =====================================
+// PresetPatch
+// =====================================
+
+// Compact difference between two attribute maps (see diff_attributes), e.g. to
+// synchronize the parameters of two processes: a slider edit only costs the changed
+// value instead of the full preset.
+class PresetPatch
+{
+public:
+  PresetPatch() = default;
+
+  // Apply the patch to the map, the attributes are modified in place (Array tiles are
+  // written straight to the array) and their version is bumped. Returns false if an
+  // attribute is missing, has a different type or does not match the patch (e.g. value
+  // size), the other attributes are patched nonetheless.
+  bool apply(std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map) const;
+
+  bool                                     empty() const;
+  const std::map<std::string, PatchEntry> &get_entries() const;
+  std::vector<std::string>                 get_keys() const;
+  void                                     set_entry(const std::string &key,
+                                                     PatchEntry       &&entry);
+  size_t                                   size() const;
+
+  // Binary serialization (native byte order, checked when reading), the JSON members are
+  // encoded as CBOR and the float blocks stored raw. Returns false, with an empty patch,
+  // if the data are not a valid patch.
+  bool              deserialize(const char *data, size_t size);
+  std::vector<char> serialize() const;
+
+private:
+  std::map<std::string, PatchEntry> entries;
+};
+
+// Patch turning the attribute states of 'attr_map_a' into those of 'attr_map_b'. The
+// values are only compared if their digests differ (see AbstractAttribute::get_hash),
+// the other members of the states (label, bounds...) are always compared. Attributes
+// missing in 'attr_map_a', of a different type or with JSON members removed in
+// 'attr_map_b' are stored whole. Attributes missing in 'attr_map_b' are ignored.
+PresetPatch diff_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map_a,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map_b);
+
+} // namespace attr
@@ -0,0 +1,59 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace attr
+{
+
+// =====================================
+// PublishedValue
+// =====================================
+
+// Read-copy-update holder for the large attribute values (arrays, clouds, paths,
+// gradients). The writer thread publishes an immutable copy of its working value, only
+// the pointer swap is done under a lock (std::atomic<std::shared_ptr> is not available
+// everywhere): readers on other threads get a consistent snapshot and keep it alive as
+// long as they hold it, whatever the writer does in the meantime.
+template <typename T> class PublishedValue
+{
+public:
+  // Any thread. Latest published value, nullptr if nothing has been published yet.
+  std::shared_ptr<const T> load() const
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->ptr;
+  }
+
+  // Writer thread only.
+  bool is_published(uint64_t version) const
+  {
+    return version == this->published_version;
+  }
+
+  // Writer thread only. 'version' is the attribute version of 'value', the copy is
+  // skipped if this version is already published.
+  void publish(const T &value, uint64_t version)
+  {
+    if (this->is_published(version))
+      return;
+
+    // copy outside of the lock, the previous snapshot is released after it
+    std::shared_ptr<const T> new_ptr = std::make_shared<const T>(value);
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->ptr.swap(new_ptr);
+    }
+    this->published_version = version;
+  }
+
+private:
+  mutable std::mutex       mutex;
+  std::shared_ptr<const T> ptr;
+  uint64_t                 published_version = UINT64_MAX;
+};
+
+} // namespace attr
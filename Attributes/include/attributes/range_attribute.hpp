@@ -2,15 +2,22 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <functional>
 
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/keyframe_track.hpp"
+#include "attributes/value_format.hpp"
 
 namespace attr
 {
 
 using PairVec = std::pair<std::vector<float>, std::vector<float>>;
 
+// Histogram computation, 'is_cancelled' is raised when its result is no longer needed
+using HistogramFct = std::function<PairVec(const std::atomic<bool> &is_cancelled)>;
+
 // =====================================
 // RangeAttribute
 // =====================================
@@ -29,28 +36,60 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
+
+  bool                      get_autorange() const;
+  HistogramFct              get_histogram_fct() const;
+  std::function<uint64_t()> get_histogram_version_fct() const;
+  bool                      get_is_active() const;
+  glm::vec2                 get_value() const;
+  SharedString              get_value_format() const;
+  float                     get_vmin() const;
+  float                     get_vmax() const;
+  void                      set_autorange(bool new_state);
+  void                      set_is_active(bool new_state);
+  void                      set_value(const glm::vec2 &new_value);
+  std::string               to_string() override;
+
+  // Histogram displayed by the widget. The function runs on a worker thread, off the
+  // GUI thread, and must be safe to call from there. The widget raises 'is_cancelled'
+  // when the result is no longer needed (newer request, widget destroyed) and waits for
+  // the computation to return when it is destroyed: long computations should poll the
+  // flag and return early. The optional version function returns a counter identifying
+  // the state of the histogram source data, the histogram is then only recomputed when
+  // the counter changes.
+  void set_histogram_fct(HistogramFct new_histogram_fct);
+  void set_histogram_fct(std::function<PairVec()> new_histogram_fct); // not cancellable
+  void set_histogram_version_fct(std::function<uint64_t()> new_histogram_version_fct);
 
-  bool                     get_autorange() const;
-  std::function<PairVec()> get_histogram_fct() const;
-  bool                     get_is_active() const;
-  glm::vec2                get_value() const;
-  std::string              get_value_format() const;
-  float                    get_vmin() const;
-  float                    get_vmax() const;
-  void                     set_autorange(bool new_state);
-  void                     set_histogram_fct(std::function<PairVec()> new_histogram_fct);
-  void                     set_is_active(bool new_state);
-  void                     set_value(const glm::vec2 &new_value);
-  std::string              to_string() override;
+  // Animation, the static value is used while the track is empty. Batch evaluation
+  // writes the values of each time to 'out' (see KeyframeTrack::evaluate).
+  ValueWriteScope<KeyframeTrack> edit_track();
+  const KeyframeTrack           &get_track() const;
+  glm::vec2                      get_value_at(float time) const;
+  void                           get_values_at(std::span<const float> times,
+                                               float                 *out) const;
+
+protected:
+  void blend_value(const AbstractAttribute &a,
+                   const AbstractAttribute &b,
+                   float                    t) override;
 
 private:
   glm::vec2                value;
   float                    vmin;
   float                    vmax;
   bool                     is_active;
-  std::string              value_format;
-  std::function<PairVec()> histogram_fct = nullptr;
+  ValueFormat<float>       value_format;
   bool                     autorange = false;
+
+  // see set_histogram_fct
+  HistogramFct              histogram_fct = nullptr;
+  std::function<uint64_t()> histogram_version_fct = nullptr;
+
+  // animation
+  KeyframeTrack track = KeyframeTrack(2);
 };
 
 } // namespace attr
@@ -5,6 +5,7 @@
 #include <utility>
 
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/value_format.hpp"
 
 namespace attr
 {
@@ -21,6 +22,8 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
   int  get_height() const;
   bool get_keep_aspect_ratio() const;
@@ -33,19 +36,19 @@ public:
   void set_width(int w);
 
   std::pair<int, int> get_value() const;
-  std::string         get_value_format() const;
+  SharedString        get_value_format() const;
   void                set_value(int w, int h);
   std::string         to_string() override;
 
 private:
   void update_aspect_ratio();
 
-  int         width;
-  int         height;
-  bool        keep_aspect_ratio;
-  bool        power_of_two;
-  float       aspect_ratio;
-  std::string value_format;
+  int              width;
+  int              height;
+  bool             keep_aspect_ratio;
+  bool             power_of_two;
+  float            aspect_ratio;
+  ValueFormat<int> value_format;
 };
 
 } // namespace attr
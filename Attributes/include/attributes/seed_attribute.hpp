@@ -21,13 +21,15 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
   uint        get_value() const;
   void        set_value(const uint &new_value);
   std::string to_string() override;
 
 private:
-  uint value;
+  std::atomic<uint> value;
 };
 
 } // namespace attr
@@ -0,0 +1,62 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <string>
+#include <string_view>
+
+#include "nlohmann/json.hpp"
+
+namespace attr
+{
+
+// Interned string storage for the attribute metadata (labels, descriptions, value
+// formats), which take a handful of distinct values over many attributes. Strings are
+// stored once in a process-wide pool (thread-safe, never shrinks) and attributes only
+// hold a pointer to them.
+
+// Stable storage of 'str' in the pool, interned on first use.
+const std::string *intern_string(std::string_view str);
+
+// =====================================
+// SharedString
+// =====================================
+
+// Immutable handle on an interned string: copies are pointer copies and equal strings
+// share the same storage. Converts implicitly to std::string_view and to
+// const std::string &, the underlying string is null-terminated (c_str).
+class SharedString
+{
+public:
+  SharedString();
+  SharedString(const char *str);
+  SharedString(const std::string &str);
+  SharedString(std::string_view str);
+
+  const char        *c_str() const { return this->p_str->c_str(); }
+  bool               empty() const { return this->p_str->empty(); }
+  size_t             size() const { return this->p_str->size(); }
+  const std::string &str() const { return *this->p_str; }
+  std::string_view   view() const { return *this->p_str; }
+
+  operator const std::string &() const { return *this->p_str; }
+  operator std::string_view() const { return *this->p_str; }
+
+  bool operator==(std::string_view other) const
+  {
+    return this->p_str->size() == other.size() &&
+           (this->p_str->data() == other.data() || *this->p_str == other);
+  }
+
+private:
+  const std::string *p_str;
+};
+
+inline void to_json(nlohmann::json &j, const SharedString &s) { j = s.str(); }
+
+inline void from_json(const nlohmann::json &j, SharedString &s)
+{
+  s = j.get<std::string>();
+}
+
+} // namespace attr
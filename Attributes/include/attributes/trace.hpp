@@ -0,0 +1,167 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace attr
+{
+
+// Tracing of the hot paths (serialization, state snapshots, widget construction...):
+// scoped timers and counters, exported as a Chrome trace (chrome://tracing, Perfetto)
+// and aggregated in duration histograms. The macros below expand to nothing unless the
+// library is built with ATTR_ENABLE_TRACING (CMake option ATTRIBUTES_ENABLE_TRACING),
+// recording is then switched on at runtime with Tracer::get().set_enabled(true).
+//
+// void ArrayWidget::update()
+// {
+//   ATTR_TRACE_SCOPE("ArrayWidget::update");
+//   ...
+// }
+
+// Events recorded per thread beyond this count are dropped, the statistics are still
+// updated
+#define ATTR_TRACE_MAX_EVENTS 1000000
+
+// Duration histogram buckets, bucket k holds the durations in [2^k, 2^(k+1)) ns
+#define ATTR_TRACE_NBUCKETS 48
+
+#ifdef ATTR_ENABLE_TRACING
+#define ATTR_TRACE_CONCAT_IMPL(a, b) a##b
+#define ATTR_TRACE_CONCAT(a, b) ATTR_TRACE_CONCAT_IMPL(a, b)
+// 'name' must be a string literal (stored as a pointer)
+#define ATTR_TRACE_SCOPE(name)                                                           \
+  attr::TraceScope ATTR_TRACE_CONCAT(attr_trace_scope_, __LINE__)(name)
+#define ATTR_TRACE_COUNTER(name, value) attr::Tracer::get().record_counter(name, value)
+#else
+#define ATTR_TRACE_SCOPE(name) ((void)0)
+#define ATTR_TRACE_COUNTER(name, value) ((void)0)
+#endif
+
+// =====================================
+// TraceStats
+// =====================================
+
+// Aggregated durations of a scope, in nanoseconds.
+struct TraceStats
+{
+  uint64_t                                count = 0;
+  uint64_t                                total = 0;
+  uint64_t                                min = UINT64_MAX;
+  uint64_t                                max = 0;
+  std::array<uint64_t, ATTR_TRACE_NBUCKETS> buckets = {};
+
+  void     add(uint64_t duration);
+  void     merge(const TraceStats &other);
+  double   mean() const;
+  uint64_t percentile(double p) const; // upper bound of the histogram bucket
+};
+
+// =====================================
+// Tracer
+// =====================================
+
+class Tracer
+{
+public:
+  static Tracer &get();
+
+  bool is_enabled() const { return this->enabled.load(std::memory_order_relaxed); }
+  void set_enabled(bool new_state);
+
+  // Remove the recorded events and statistics.
+  void clear();
+
+  // Record a scope of the calling thread, times from clock(). 'name' must outlive the
+  // tracer (string literal).
+  void record_scope(const char *name, int64_t t_start, int64_t t_end);
+
+  // Record the value of a counter, shown as a track in the trace viewers.
+  void record_counter(const char *name, double value);
+
+  // Statistics of each scope name, all threads merged.
+  std::map<std::string, TraceStats> get_stats() const;
+
+  // One line per scope name (count, mean, min, p50, p99, max), longest total first.
+  std::string get_stats_string() const;
+
+  // Chrome trace event format (JSON), loaded by chrome://tracing and Perfetto.
+  bool save_chrome_trace(const std::string &fname) const;
+  void write_chrome_trace(std::ostream &os) const;
+
+  // Monotonic time in nanoseconds.
+  static int64_t clock()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+private:
+  struct Event
+  {
+    const char *name;
+    int64_t     t_start;
+    int64_t     duration; // -1 for a counter
+    double      value;
+  };
+
+  // Events of a thread, kept after the thread exits. The mutex is only contended while
+  // exporting.
+  struct ThreadBuffer
+  {
+    std::mutex                          mutex;
+    uint64_t                            tid = 0;
+    std::vector<Event>                  events;
+    std::map<const char *, TraceStats> stats;
+  };
+
+  Tracer();
+  Tracer(const Tracer &) = delete;
+  Tracer &operator=(const Tracer &) = delete;
+
+  ThreadBuffer &get_thread_buffer();
+
+  std::atomic<bool>                          enabled = false;
+  int64_t                                    t_origin;
+  mutable std::mutex                         mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+// =====================================
+// TraceScope
+// =====================================
+
+// Records the duration of the enclosing scope, see ATTR_TRACE_SCOPE.
+class TraceScope
+{
+public:
+  explicit TraceScope(const char *name)
+      : name(name), t_start(Tracer::get().is_enabled() ? Tracer::clock() : -1)
+  {
+  }
+
+  ~TraceScope()
+  {
+    if (this->t_start >= 0)
+      Tracer::get().record_scope(this->name, this->t_start, Tracer::clock());
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+  const char *name;
+  int64_t     t_start;
+};
+
+} // namespace attr
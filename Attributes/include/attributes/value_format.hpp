@@ -0,0 +1,49 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <format>
+#include <string>
+#include <type_traits>
+
+#include "attributes/logger.hpp"
+#include "attributes/shared_string.hpp"
+
+namespace attr
+{
+
+// =====================================
+// ValueFormat
+// =====================================
+
+// std::format pattern of a numeric value (e.g. "{:.3f}"), validated once when the
+// attribute is created so that the widgets never receive a pattern that throws while
+// painting. Invalid patterns are reported and replaced by "{}".
+template <typename T> class ValueFormat
+{
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, int>);
+
+public:
+  ValueFormat(const std::string &pattern = "{}") : pattern(pattern)
+  {
+    try
+    {
+      T probe = T(0);
+      (void)std::vformat(pattern, std::make_format_args(probe));
+    }
+    catch (const std::format_error &e)
+    {
+      Logger::log()->error("ValueFormat: invalid format \"{}\" ({}), using \"{{}}\"",
+                           pattern,
+                           e.what());
+      this->pattern = "{}";
+    }
+  }
+
+  SharedString get_pattern() const { return this->pattern; }
+
+private:
+  SharedString pattern;
+};
+
+} // namespace attr
@@ -5,6 +5,7 @@
 #include <glm/glm.hpp>
 
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/keyframe_track.hpp"
 
 namespace attr
 {
@@ -27,6 +28,8 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
   glm::vec2   get_value() const;
   float       get_xmin() const;
@@ -36,10 +39,26 @@ public:
   void        set_value(const glm::vec2 &new_value);
   std::string to_string() override;
 
+  // Animation, the static value is used while the track is empty. Batch evaluation
+  // writes the values of each time to 'out' (see KeyframeTrack::evaluate).
+  ValueWriteScope<KeyframeTrack> edit_track();
+  const KeyframeTrack           &get_track() const;
+  glm::vec2                      get_value_at(float time) const;
+  void                           get_values_at(std::span<const float> times,
+                                               float                 *out) const;
+
+protected:
+  void blend_value(const AbstractAttribute &a,
+                   const AbstractAttribute &b,
+                   float                    t) override;
+
 private:
   glm::vec2 value;
   float     xmin, xmax;
   float     ymin, ymax;
+
+  // animation
+  KeyframeTrack track = KeyframeTrack(2);
 };
 
 } // namespace attr
@@ -21,13 +21,22 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
-  std::vector<float>  get_value() const;
-  std::vector<float> *get_value_ref();
-  float               get_vmin() const;
-  float               get_vmax() const;
-  void                set_value(const std::vector<float> &new_value);
-  std::string         to_string() override;
+  ValueWriteScope<std::vector<float>> edit_value();
+  std::vector<float>                  get_value() const;
+  // deprecated for writes, see edit_value
+  std::vector<float>                 *get_value_ref();
+  float                               get_vmin() const;
+  float                               get_vmax() const;
+  void                                set_value(const std::vector<float> &new_value);
+  std::string                         to_string() override;
+
+protected:
+  void blend_value(const AbstractAttribute &a,
+                   const AbstractAttribute &b,
+                   float                    t) override;
 
 private:
   std::vector<float> value;
@@ -21,13 +21,17 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
-  std::vector<int>  get_value() const;
-  std::vector<int> *get_value_ref();
-  int               get_vmin() const;
-  int               get_vmax() const;
-  void              set_value(const std::vector<int> &new_value);
-  std::string       to_string() override;
+  ValueWriteScope<std::vector<int>> edit_value();
+  std::vector<int>                  get_value() const;
+  // deprecated for writes, see edit_value
+  std::vector<int>                 *get_value_ref();
+  int                               get_vmin() const;
+  int                               get_vmax() const;
+  void                              set_value(const std::vector<int> &new_value);
+  std::string                       to_string() override;
 
 private:
   std::vector<int> value;
@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/keyframe_track.hpp"
+#include "attributes/value_format.hpp"
 
 namespace attr
 {
@@ -27,22 +29,40 @@ public:
 
   void           json_from(nlohmann::json const &json) override;
   nlohmann::json json_to() const override;
+  uint64_t       hash() const override;
+  MemoryUsage    memory_usage() const override;
 
-  bool        get_link_xy() const;
-  glm::vec2   get_value() const;
-  std::string get_value_format() const;
-  float       get_vmin() const;
-  float       get_vmax() const;
-  void        set_link_xy(const bool new_state);
-  void        set_value(const glm::vec2 &new_value);
-  std::string to_string() override;
+  bool         get_link_xy() const;
+  glm::vec2    get_value() const;
+  SharedString get_value_format() const;
+  float        get_vmin() const;
+  float        get_vmax() const;
+  void         set_link_xy(const bool new_state);
+  void         set_value(const glm::vec2 &new_value);
+  std::string  to_string() override;
+
+  // Animation, the static value is used while the track is empty. Batch evaluation
+  // writes the values of each time to 'out' (see KeyframeTrack::evaluate).
+  ValueWriteScope<KeyframeTrack> edit_track();
+  const KeyframeTrack           &get_track() const;
+  glm::vec2                      get_value_at(float time) const;
+  void                           get_values_at(std::span<const float> times,
+                                               float                 *out) const;
+
+protected:
+  void blend_value(const AbstractAttribute &a,
+                   const AbstractAttribute &b,
+                   float                    t) override;
 
 private:
-  glm::vec2   value;
-  float       vmin;
-  float       vmax;
-  bool        link_xy;
-  std::string value_format;
+  glm::vec2          value;
+  float              vmin;
+  float              vmax;
+  bool               link_xy;
+  ValueFormat<float> value_format;
+
+  // animation
+  KeyframeTrack track = KeyframeTrack(2);
 };
 
 } // namespace attr
@@ -2,14 +2,23 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #pragma once
+#include <QLabel>
+#include <QTimer>
 #include <QWidget>
 
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/preset_journal.hpp"
 #include "attributes/widgets/abstract_widget.hpp"
 
 namespace attr
 {
 
+// Value changes are written to the autosave journal at most once per this delay
+#define ATTR_AUTOSAVE_DELAY_MS 500
+
+// The memory overlay is refreshed at most once per this delay while values change
+#define ATTR_MEMORY_OVERLAY_DELAY_MS 1000
+
 // =====================================
 // AttributesWidget
 // =====================================
@@ -27,14 +36,33 @@ public:
                    const bool                add_save_reset_state_buttons = false,
                    QWidget                  *parent = nullptr);
 
+  // Write the changes not yet saved to the autosave journal. The widget does not flush
+  // itself when destroyed (the attribute map may already be gone), the owner of the map
+  // must call it before releasing the map to keep the last changes.
+  void flush_autosave();
+
+  // Save the attributes to the journal 'fname' when values change, only the modified
+  // attributes are written (see PresetJournal). The changes are coalesced, the journal
+  // is written ATTR_AUTOSAVE_DELAY_MS after the first change (see flush_autosave). If
+  // 'load' is true, the journal content is loaded first. An empty filename disables
+  // autosaving.
+  void set_autosave_journal(const std::string &fname, bool load = false);
+
+  // Debug overlay: show the memory used by the attributes (see memory_usage_attributes)
+  // below the widgets. It is refreshed when the state is saved and, while values change,
+  // at most once every ATTR_MEMORY_OVERLAY_DELAY_MS.
+  void set_memory_overlay(bool enabled);
+
   QSize sizeHint() const;
 
 public slots:
+  void on_autosave();
   void on_load_preset();
   void on_restore_initial_state();
   void on_restore_save_state();
   void on_save_state();
   void on_save_preset();
+  void on_update_memory_overlay();
 
 signals:
   void update_button_released();
@@ -45,6 +73,14 @@ private:
   std::vector<std::string>                                  *p_attr_ordered_key;
 
   std::map<std::string, AbstractWidget *> widget_map = {};
+
+  std::unique_ptr<PresetJournal> journal;
+  QMetaObject::Connection        autosave_connection;
+  QTimer                        *autosave_timer = nullptr;
+
+  QLabel                 *memory_label = nullptr;
+  QMetaObject::Connection memory_connection;
+  QTimer                 *memory_timer = nullptr;
 };
 
 AbstractWidget *get_attribute_widget(AbstractAttribute *p_attr);
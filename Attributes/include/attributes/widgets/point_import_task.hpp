@@ -0,0 +1,23 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#pragma once
+#include <functional>
+#include <string>
+
+#include <QWidget>
+
+#include "attributes/point_import.hpp"
+
+namespace attr
+{
+
+// Import a point file (see import_points) on the Qt thread pool, with a progress dialog
+// offering to cancel it. The task is owned by 'parent': deleting it cancels the import
+// and waits for it to end. 'done_fct' is called on the GUI thread with the imported
+// buffers, unless the import fails or is canceled.
+void import_points_async(QWidget                              *parent,
+                         const std::string                    &fname,
+                         std::function<void(CloudBuffers &&)> done_fct);
+
+} // namespace attr
@@ -2,6 +2,10 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #include <QPushButton>
 
 #include "qsx/slider_range.hpp"
@@ -12,6 +16,26 @@
 namespace attr
 {
 
+// =====================================
+// HistogramWorkerState
+// =====================================
+
+// Shared between a RangeWidget and its histogram worker thread. The widget cancels the
+// current computation and joins the worker when it is destroyed
+struct HistogramWorkerState
+{
+  std::mutex        mutex;
+  bool              widget_alive = true;
+  bool              worker_running = false;
+  bool              pending = false;      // new request received during a computation
+  std::atomic<bool> is_cancelled = false; // current computation no longer needed
+  uint64_t          generation = 0;       // id of the latest request
+  HistogramFct      histogram_fct;        // histogram function of the latest request
+  bool              has_source_version = false;
+  uint64_t          source_version = 0; // source version of the latest request
+  PairVec           histogram;          // last valid histogram
+};
+
 // =====================================
 // RangeWidget
 // =====================================
@@ -23,18 +47,28 @@ class RangeWidget : public AbstractWidget
 public:
   RangeWidget() = delete;
   RangeWidget(RangeAttribute *p_attr);
+  ~RangeWidget() override;
 
   void reset_value(bool reset_to_initial_state = false) override;
 
 signals:
   void update_bins();
 
+public slots:
+  void on_update_bins();
+
 private:
+  void on_histogram_ready(uint64_t generation);
   void update_attribute_from_widget();
 
-  RangeAttribute   *p_attr;
-  qsx::SliderRange *slider;
-  glm::vec2         value_bckp;
+  static void run_histogram_worker(std::shared_ptr<HistogramWorkerState> state,
+                                   RangeWidget                          *p_widget);
+
+  RangeAttribute                       *p_attr;
+  qsx::SliderRange                     *slider;
+  glm::vec2                             value_bckp;
+  std::shared_ptr<HistogramWorkerState> histogram_state;
+  std::thread                           histogram_worker;
 };
 
 } // namespace attr
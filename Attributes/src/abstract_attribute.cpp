@@ -2,19 +2,118 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 
+#include <algorithm>
+#include <format>
+
 #include "attributes/abstract_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
 
+// helpers
+
+// allocation of the attribute being constructed by create_attr on this thread
+static thread_local std::pmr::memory_resource *p_pending_resource = nullptr;
+static thread_local size_t                     pending_size = 0;
+static thread_local size_t                     pending_alignment = 0;
+
+// class definition
+
+AttributeAllocation::AttributeAllocation()
+{
+  if (p_pending_resource)
+  {
+    this->p_resource = p_pending_resource;
+    this->size = pending_size;
+    this->alignment = pending_alignment;
+
+    // only the outermost attribute being constructed is concerned
+    p_pending_resource = nullptr;
+  }
+}
+
 AbstractAttribute::AbstractAttribute(const AttributeType &type, const std::string &label)
     : type(type), label(label)
 {
 }
 
-std::string AbstractAttribute::get_description() const { return this->description; }
+void AbstractAttribute::operator delete(AbstractAttribute *p_attr,
+                                        std::destroying_delete_t)
+{
+  std::pmr::memory_resource *p_resource = p_attr->allocation.p_resource;
+  size_t                     size = p_attr->allocation.size;
+  size_t                     alignment = p_attr->allocation.alignment;
+
+  // start of the most derived object, i.e. of the allocation
+  void *ptr = dynamic_cast<void *>(p_attr);
+
+  p_attr->~AbstractAttribute();
+
+  if (p_resource)
+    p_resource->deallocate(ptr, size, alignment);
+  else
+    ::operator delete(ptr);
+}
+
+bool AbstractAttribute::blend(const AbstractAttribute &a,
+                              const AbstractAttribute &b,
+                              float                    t)
+{
+  if (a.type != this->type || b.type != this->type)
+  {
+    Logger::log()->error("AbstractAttribute::blend: incompatible types, {}, {} and {}",
+                         a.get_type_string(),
+                         b.get_type_string(),
+                         this->get_type_string());
+    return false;
+  }
+
+  this->blend_value(a, b, std::clamp(t, 0.f, 1.f));
+  return true;
+}
+
+void AbstractAttribute::blend_value(const AbstractAttribute &a,
+                                    const AbstractAttribute &b,
+                                    float                    t)
+{
+  const AbstractAttribute &src = t < 0.5f ? a : b;
+
+  if (&src == this)
+    return;
+
+  // copy the state but the label, the large arrays are moved in without a JSON tree
+  BulkArrays     bulk;
+  nlohmann::json json = src.json_to_bulk(bulk);
+
+  json["label"] = this->label;
+  this->json_from_bulk(json, bulk);
+}
+
+void AbstractAttribute::bump_version() { this->version++; }
+
+SharedString AbstractAttribute::get_description() const { return this->description; }
+
+uint64_t AbstractAttribute::get_hash() const
+{
+  if (this->hash_version != this->version)
+  {
+    this->hash_cache = hash_combine(hash_value(this->type), this->hash());
+    this->hash_version = this->version;
+  }
+
+  return this->hash_cache;
+}
+
+SharedString AbstractAttribute::get_label() const { return this->label; }
 
-std::string AbstractAttribute::get_label() const { return this->label; }
+std::pmr::memory_resource *AbstractAttribute::get_memory_resource() const
+{
+  return this->allocation.p_resource ? this->allocation.p_resource
+                                     : std::pmr::get_default_resource();
+}
 
 AttributeType AbstractAttribute::get_type() const { return this->type; }
 
@@ -26,10 +125,23 @@ std::string AbstractAttribute::get_type_string() const
     return "INVALID TYPE";
 }
 
+uint64_t AbstractAttribute::get_version() const { return this->version; }
+
+uint64_t AbstractAttribute::hash() const
+{
+  // fallback, serialized state without the label
+  nlohmann::json json = this->json_to();
+  json.erase("label");
+  return hash_string(json.dump());
+}
+
 void AbstractAttribute::json_from(nlohmann::json const &json)
 {
-  json_safe_get<AttributeType>(json, "type", type);
-  json_safe_get(json, "label", label);
+  // "type" and "label" only
+  static const JsonSchema<AbstractAttribute> schema;
+
+  this->bump_version();
+  schema.read(json, *this);
 }
 
 nlohmann::json AbstractAttribute::json_to() const
@@ -41,51 +153,101 @@ nlohmann::json AbstractAttribute::json_to() const
   return json;
 }
 
+void AbstractAttribute::json_from_bulk(nlohmann::json const &json, BulkArrays &bulk)
+{
+  nlohmann::json merged = json;
+  for (auto &[key, vec] : bulk)
+    merged[key] = vec;
+
+  this->json_from(merged);
+}
+
+nlohmann::json AbstractAttribute::json_to_bulk(BulkArrays & /* bulk */) const
+{
+  return this->json_to();
+}
+
+void AbstractAttribute::json_write(std::ostream &os) const { os << this->json_to(); }
+
+MemoryUsage AbstractAttribute::memory_usage() const
+{
+  auto bulk_memory_usage = [](const BulkArrays &bulk)
+  {
+    size_t n = 0;
+    for (auto &[key, vec] : bulk)
+      n += 4 * sizeof(void *) + sizeof(BulkArrays::value_type) +
+           string_memory_usage(key) + vector_memory_usage(vec);
+    return n;
+  };
+
+  // the object size is added by the derived class
+  MemoryUsage usage;
+  usage.state = json_memory_usage(this->attribute_state) +
+                bulk_memory_usage(this->attribute_state_bulk);
+  usage.initial_state = json_memory_usage(this->attribute_initial_state) +
+                        bulk_memory_usage(this->attribute_initial_state_bulk);
+  return usage;
+}
+
 void AbstractAttribute::reset_to_initial_state()
 {
+  ATTR_TRACE_SCOPE("AbstractAttribute::reset_to_initial_state");
+
   if (this->attribute_initial_state.is_null())
   {
     Logger::log()->error("AbstractAttribute::reset_to_initial_state: empty saved state, "
                          "could not reset attribute state. attribute label: {}",
-                         this->label);
+                         this->label.str());
     return;
   }
 
-  this->json_from(this->attribute_initial_state);
+  // the initial state is kept, json_from_bulk consumes its bulk argument
+  BulkArrays bulk = this->attribute_initial_state_bulk;
+  this->json_from_bulk(this->attribute_initial_state, bulk);
 }
 
 void AbstractAttribute::reset_to_save_state()
 {
+  ATTR_TRACE_SCOPE("AbstractAttribute::reset_to_save_state");
+
   if (this->attribute_state.is_null())
   {
     Logger::log()->error("AbstractAttribute::reset_to_save_state: empty saved state, "
                          "could not reset attribute state. attribute label: {}",
-                         this->label);
+                         this->label.str());
   }
   else
   {
     // actually switch current state and save state to allow
     // "toggling" between the two states when resetting the state
-    nlohmann::json current_state = this->json_to();
+    BulkArrays     current_bulk;
+    nlohmann::json current_state = this->json_to_bulk(current_bulk);
 
     // restore
-    this->json_from(this->attribute_state);
+    this->json_from_bulk(this->attribute_state, this->attribute_state_bulk);
 
     // current to backup
-    this->attribute_state = current_state;
+    this->attribute_state = std::move(current_state);
+    this->attribute_state_bulk = std::move(current_bulk);
   }
 }
 
 void AbstractAttribute::save_initial_state()
 {
+  ATTR_TRACE_SCOPE("AbstractAttribute::save_initial_state");
+
   // serialize current state
-  this->attribute_initial_state = this->json_to();
+  this->attribute_initial_state_bulk.clear();
+  this->attribute_initial_state = this->json_to_bulk(this->attribute_initial_state_bulk);
 }
 
 void AbstractAttribute::save_state()
 {
+  ATTR_TRACE_SCOPE("AbstractAttribute::save_state");
+
   // serialize current state
-  this->attribute_state = this->json_to();
+  this->attribute_state_bulk.clear();
+  this->attribute_state = this->json_to_bulk(this->attribute_state_bulk);
 }
 
 void AbstractAttribute::set_description(const std::string &new_description)
@@ -98,4 +260,193 @@ void AbstractAttribute::set_label(const std::string &new_label)
   this->label = new_label;
 }
 
+MemoryUsage &MemoryUsage::operator+=(const MemoryUsage &other)
+{
+  this->value += other.value;
+  this->state += other.state;
+  this->initial_state += other.initial_state;
+  this->metadata += other.metadata;
+  this->cache += other.cache;
+  return *this;
+}
+
+size_t MemoryUsage::total() const
+{
+  return this->value + this->state + this->initial_state + this->metadata + this->cache;
+}
+
+std::string MemoryUsage::to_string() const
+{
+  return std::format("{} (value {}, state {}, initial state {}, metadata {}, cache {})",
+                     format_bytes(this->total()),
+                     format_bytes(this->value),
+                     format_bytes(this->state),
+                     format_bytes(this->initial_state),
+                     format_bytes(this->metadata),
+                     format_bytes(this->cache));
+}
+
+std::string MemoryReport::to_string() const
+{
+  std::vector<const std::pair<const std::string, MemoryUsage> *> sorted;
+  for (auto &entry : this->entries)
+    sorted.push_back(&entry);
+
+  std::stable_sort(sorted.begin(),
+                   sorted.end(),
+                   [](const auto *a, const auto *b)
+                   { return a->second.total() > b->second.total(); });
+
+  std::string str;
+  for (auto *p_entry : sorted)
+    str += std::format("{}: {}\n", p_entry->first, p_entry->second.to_string());
+
+  str += std::format("total: {}", this->total.to_string());
+  return str;
+}
+
+// functions
+
+bool blend_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map_a,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map_b,
+    float                                                            t,
+    std::map<std::string, std::unique_ptr<AbstractAttribute>>       &attr_map_dst)
+{
+  bool ret = true;
+
+  for (auto &[key, pa] : attr_map_dst)
+  {
+    auto it_a = attr_map_a.find(key);
+    auto it_b = attr_map_b.find(key);
+
+    if (!pa || it_a == attr_map_a.end() || it_b == attr_map_b.end() || !it_a->second ||
+        !it_b->second)
+    {
+      Logger::log()->error("blend_attributes: attribute {} not found", key);
+      ret = false;
+      continue;
+    }
+
+    if (!pa->blend(*it_a->second, *it_b->second, t))
+    {
+      Logger::log()->error("blend_attributes: attribute {} could not be blended", key);
+      ret = false;
+    }
+  }
+
+  return ret;
+}
+
+std::string format_bytes(size_t nbytes)
+{
+  if (nbytes < 1024)
+    return std::format("{} B", nbytes);
+
+  const char *units[] = {"KiB", "MiB", "GiB", "TiB"};
+  double      v = static_cast<double>(nbytes) / 1024.;
+  size_t      k = 0;
+
+  for (; v >= 1024. && k < 3; k++)
+    v /= 1024.;
+
+  return std::format("{:.1f} {}", v, units[k]);
+}
+
+uint64_t hash_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map)
+{
+  uint64_t h = hash_value(attr_map.size());
+
+  for (auto &[key, pa] : attr_map)
+  {
+    h = hash_combine(h, hash_string(key));
+    h = hash_combine(h, pa ? pa->get_hash() : 0);
+  }
+
+  return h;
+}
+
+size_t json_memory_usage(const nlohmann::json &json)
+{
+  switch (json.type())
+  {
+  case nlohmann::json::value_t::object:
+  {
+    // red-black tree nodes: links and color, then the key / value pair
+    const size_t node_size = 4 * sizeof(void *) +
+                             sizeof(nlohmann::json::object_t::value_type);
+
+    size_t n = sizeof(nlohmann::json::object_t);
+    for (auto &[key, v] : json.get_ref<const nlohmann::json::object_t &>())
+      n += node_size + string_memory_usage(key) + json_memory_usage(v);
+    return n;
+  }
+  case nlohmann::json::value_t::array:
+  {
+    const auto &array = json.get_ref<const nlohmann::json::array_t &>();
+
+    size_t n = sizeof(nlohmann::json::array_t) + vector_memory_usage(array);
+    for (auto &v : array)
+      n += json_memory_usage(v);
+    return n;
+  }
+  case nlohmann::json::value_t::string:
+    return sizeof(std::string) +
+           string_memory_usage(json.get_ref<const std::string &>());
+  case nlohmann::json::value_t::binary:
+    return sizeof(nlohmann::json::binary_t) + vector_memory_usage(json.get_binary());
+  default:
+    // stored in the node
+    return 0;
+  }
+}
+
+MemoryReport memory_usage_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map)
+{
+  MemoryReport report;
+
+  for (auto &[key, pa] : attr_map)
+  {
+    if (!pa)
+      continue;
+
+    MemoryUsage usage = pa->memory_usage();
+    report.total += usage;
+    report.entries[key] = usage;
+  }
+
+  return report;
+}
+
+void publish_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map)
+{
+  for (auto &[_, pa] : attr_map)
+    if (pa)
+      pa->publish();
+}
+
+void set_pending_attribute_allocation(std::pmr::memory_resource *p_resource,
+                                      size_t                     size,
+                                      size_t                     alignment)
+{
+  p_pending_resource = p_resource;
+  pending_size = size;
+  pending_alignment = alignment;
+}
+
+size_t string_memory_usage(const std::string &str)
+{
+  // the characters are stored inline when the string fits in the object
+  const char *p_begin = reinterpret_cast<const char *>(&str);
+  const char *p_data = str.data();
+
+  if (p_data >= p_begin && p_data < p_begin + sizeof(std::string))
+    return 0;
+
+  return str.capacity() + 1;
+}
+
 } // namespace attr
@@ -2,11 +2,52 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 
+#include <cmath>
+
 #include "attributes/array_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/json_stream.hpp"
+#include "attributes/parallel.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
 
+// helpers
+
+namespace
+{
+
+struct PartialStats
+{
+  size_t count = 0;
+  double mean = 0.0;
+  double m2 = 0.0; // sum of squared differences from the mean
+  float  min = FLT_MAX;
+  float  max = -FLT_MAX;
+};
+
+// Chan et al. pairwise update, numerically stable when merging chunk moments
+void merge_partial_stats(PartialStats &a, const PartialStats &b)
+{
+  if (b.count == 0)
+    return;
+
+  size_t count = a.count + b.count;
+  double delta = b.mean - a.mean;
+
+  a.mean += delta * (double)b.count / (double)count;
+  a.m2 += b.m2 + delta * delta * (double)a.count * (double)b.count / (double)count;
+  a.count = count;
+  a.min = std::min(a.min, b.min);
+  a.max = std::max(a.max, b.max);
+}
+
+} // namespace
+
+// class definition
+
 ArrayAttribute::ArrayAttribute(const std::string &label, const glm::ivec2 &shape)
     : AbstractAttribute(AttributeType::HMAP_ARRAY, label)
 {
@@ -23,6 +64,45 @@ ArrayAttribute::ArrayAttribute(const std::string &label, const hmap::Array &valu
   this->save_initial_state();
 }
 
+void ArrayAttribute::blend_value(const AbstractAttribute &a,
+                                 const AbstractAttribute &b,
+                                 float                    t)
+{
+  const hmap::Array &va = static_cast<const ArrayAttribute &>(a).value;
+  const hmap::Array &vb = static_cast<const ArrayAttribute &>(b).value;
+
+  if (va.shape != vb.shape)
+  {
+    AbstractAttribute::blend_value(a, b, t);
+    return;
+  }
+
+  // no allocation if the destination already has the right shape, 'a' or 'b' may be
+  // this attribute
+  if (this->value.shape != va.shape)
+    this->value = hmap::Array(va.shape);
+
+  const float *pa = va.vector.data();
+  const float *pb = vb.vector.data();
+  float       *pv = this->value.vector.data();
+  size_t       n = this->value.vector.size();
+
+  parallel_for_chunks(n,
+                      parallel_chunk_count(n),
+                      [&](size_t /* ichunk */, size_t begin, size_t end)
+                      {
+                        for (size_t k = begin; k < end; ++k)
+                          pv[k] = pa[k] + t * (pb[k] - pa[k]);
+                      });
+
+  this->bump_version();
+}
+
+ValueWriteScope<hmap::Array> ArrayAttribute::edit_value()
+{
+  return ValueWriteScope<hmap::Array>(this, &this->value);
+}
+
 std::function<QImage()> ArrayAttribute::get_background_image_fct() const
 {
   return this->background_image_fct;
@@ -30,20 +110,50 @@ std::function<QImage()> ArrayAttribute::get_background_image_fct() const
 
 void ArrayAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
+  ATTR_TRACE_SCOPE("ArrayAttribute::json_from");
 
-  glm::ivec2 shape(json["shape.x"], json["shape.y"]);
-  this->value = hmap::Array(shape);
+  BulkArrays bulk;
+  this->json_from_bulk(json, bulk);
+}
 
-  std::vector<float> vector = json["vector"].get<std::vector<float>>();
-  this->value.vector = vector;
+void ArrayAttribute::json_from_bulk(nlohmann::json const &json, BulkArrays &bulk)
+{
+  ATTR_TRACE_SCOPE("ArrayAttribute::json_from_bulk");
 
-  this->save_state();
-  this->save_initial_state();
+  using Schema = JsonSchema<ArrayAttribute>;
+
+  // "vector" is only found in 'json' when called from json_from
+  static const Schema schema = {
+      {"shape.x",
+       [](ArrayAttribute &a, const nlohmann::json &j) { j.get_to(a.value.shape.x); }},
+      {"shape.y",
+       [](ArrayAttribute &a, const nlohmann::json &j) { j.get_to(a.value.shape.y); }},
+      Schema::bulk("vector")};
+
+  this->bump_version();
+  schema.read(json, *this, &bulk);
+
+  glm::ivec2 shape = this->value.shape;
+  this->value.vector = std::move(bulk["vector"]);
+
+  if (this->value.vector.size() != (size_t)(shape.x * shape.y))
+  {
+    Logger::log()->error("ArrayAttribute::json_from_bulk: inconsistent data size ({}) "
+                         "and shape ({}, {}), attribute label: {}",
+                         this->value.vector.size(),
+                         shape.x,
+                         shape.y,
+                         this->label.str());
+    this->value = hmap::Array(shape);
+  }
 }
 
+std::vector<std::string> ArrayAttribute::json_bulk_keys() const { return {"vector"}; }
+
 nlohmann::json ArrayAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("ArrayAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
 
   json["shape.x"] = this->value.shape.x;
@@ -53,16 +163,210 @@ nlohmann::json ArrayAttribute::json_to() const
   return json;
 }
 
+nlohmann::json ArrayAttribute::json_to_bulk(BulkArrays &bulk) const
+{
+  ATTR_TRACE_SCOPE("ArrayAttribute::json_to_bulk");
+
+  nlohmann::json json = AbstractAttribute::json_to();
+
+  json["shape.x"] = this->value.shape.x;
+  json["shape.y"] = this->value.shape.y;
+  bulk["vector"] = this->value.vector;
+
+  return json;
+}
+
+void ArrayAttribute::json_write(std::ostream &os) const
+{
+  nlohmann::json head = AbstractAttribute::json_to();
+  head["shape.x"] = this->value.shape.x;
+  head["shape.y"] = this->value.shape.y;
+
+  const float *data = this->value.vector.data();
+
+  json_write_head(os, head);
+  os << ",\"vector\":";
+  json_write_float_array(os,
+                         this->value.vector.size(),
+                         [data](size_t k) { return data[k]; });
+  os << '}';
+}
+
+uint64_t ArrayAttribute::hash() const
+{
+  uint64_t h = hash_value(this->value.shape);
+  return hash_combine(h, hash_vector(this->value.vector));
+}
+
+MemoryUsage ArrayAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+
+  usage.value += vector_memory_usage(this->value.vector);
+  {
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+    usage.cache += vector_memory_usage(this->histogram.first) +
+                   vector_memory_usage(this->histogram.second);
+  }
+
+  if (auto p_snapshot = this->published_value.load())
+    usage.cache += sizeof(hmap::Array) + vector_memory_usage(p_snapshot->vector);
+  return usage;
+}
+
+PairVec ArrayAttribute::get_histogram(int nbins) const
+{
+  nbins = std::max(1, nbins);
+
+  // before locking, get_stats uses the same lock
+  ArrayStats st = this->get_stats();
+  uint64_t   version = this->get_version();
+
+  std::lock_guard<std::mutex> lock(this->cache_mutex);
+
+  if (this->histogram_version == version && this->histogram_nbins == nbins)
+    return this->histogram;
+
+  const float *data = this->value.vector.data();
+  size_t       n = this->value.vector.size();
+  float        bin_width = (st.max - st.min) / (float)nbins;
+  float        inv_bin_width = bin_width > 0.f ? 1.f / bin_width : 0.f;
+
+  size_t                           nchunks = parallel_chunk_count(n);
+  std::vector<std::vector<size_t>> partial(nchunks, std::vector<size_t>(nbins, 0));
+
+  parallel_for_chunks(n,
+                      nchunks,
+                      [&](size_t ichunk, size_t begin, size_t end)
+                      {
+                        std::vector<size_t> &counts = partial[ichunk];
+                        for (size_t k = begin; k < end; ++k)
+                        {
+                          if (!std::isfinite(data[k]))
+                            continue;
+
+                          // clamped as a float, out of range values would overflow
+                          // the integer conversion
+                          float f = (data[k] - st.min) * inv_bin_width;
+                          counts[(int)std::clamp(f, 0.f, (float)(nbins - 1))]++;
+                        }
+                      });
+
+  std::vector<float> centers(nbins);
+  std::vector<float> counts(nbins, 0.f);
+  float              norm = n > 0 ? 1.f / (float)n : 0.f;
+
+  for (int ib = 0; ib < nbins; ++ib)
+  {
+    size_t sum = 0;
+    for (auto &c : partial)
+      sum += c[ib];
+
+    centers[ib] = st.min + ((float)ib + 0.5f) * bin_width;
+    counts[ib] = (float)sum * norm;
+  }
+
+  this->histogram = {centers, counts};
+  this->histogram_nbins = nbins;
+  this->histogram_version = version;
+
+  return this->histogram;
+}
+
+ArrayStats ArrayAttribute::get_stats() const
+{
+  uint64_t version = this->get_version();
+
+  std::lock_guard<std::mutex> lock(this->cache_mutex);
+
+  if (this->stats_version == version)
+    return this->stats;
+
+  const float *data = this->value.vector.data();
+  size_t       n = this->value.vector.size();
+
+  // single pass over the data for min, max and moments
+  size_t                    nchunks = parallel_chunk_count(n);
+  std::vector<PartialStats> partial(nchunks);
+
+  parallel_for_chunks(n,
+                      nchunks,
+                      [&](size_t ichunk, size_t begin, size_t end)
+                      {
+                        PartialStats &ps = partial[ichunk];
+                        for (size_t k = begin; k < end; ++k)
+                        {
+                          float v = data[k];
+
+                          if (!std::isfinite(v))
+                            continue;
+
+                          double delta = (double)v - ps.mean;
+
+                          ps.count++;
+                          ps.mean += delta / (double)ps.count;
+                          ps.m2 += delta * ((double)v - ps.mean);
+                          ps.min = std::min(ps.min, v);
+                          ps.max = std::max(ps.max, v);
+                        }
+                      });
+
+  PartialStats total;
+  for (auto &ps : partial)
+    merge_partial_stats(total, ps);
+
+  if (total.count > 0)
+  {
+    this->stats.min = total.min;
+    this->stats.max = total.max;
+    this->stats.mean = (float)total.mean;
+    this->stats.stddev = (float)std::sqrt(total.m2 / (double)total.count);
+  }
+  else
+    this->stats = ArrayStats();
+
+  this->stats_version = version;
+
+  return this->stats;
+}
+
+std::shared_ptr<const hmap::Array> ArrayAttribute::get_snapshot() const
+{
+  return this->published_value.load();
+}
+
+const hmap::Array &ArrayAttribute::get_value_cref() const { return this->value; }
+
+hmap::Array *ArrayAttribute::get_value_ref()
+{
+  // the caller is given write access, consider the value as modified
+  this->bump_version();
+  return &this->value;
+}
+
+void ArrayAttribute::publish()
+{
+  this->published_value.publish(this->value, this->get_version());
+}
+
 void ArrayAttribute::set_background_image_fct(std::function<QImage()> new_fct)
 {
   this->background_image_fct = new_fct;
 }
 
+void ArrayAttribute::set_value(const hmap::Array &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
+
 std::string ArrayAttribute::to_string()
 {
+  ArrayStats  st = this->get_stats();
   std::string str = "";
-  str += "min: " + std::to_string(this->value.min()) + "; ";
-  str += "max: " + std::to_string(this->value.max()) + "; ";
+  str += "min: " + std::to_string(st.min) + "; ";
+  str += "max: " + std::to_string(st.max) + "; ";
   str += "shape: {" + std::to_string(this->value.shape.x) + ", " +
          std::to_string(this->value.shape.y) + "}";
 
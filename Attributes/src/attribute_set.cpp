@@ -0,0 +1,244 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include "attributes/attribute_set.hpp"
+
+namespace attr
+{
+
+// helpers
+
+// Interned key strings, stored in a deque so that references (and the views used as
+// hash keys) stay valid as the pool grows.
+struct KeyPool
+{
+  std::shared_mutex                                    mutex;
+  std::deque<std::string>                              strings;
+  std::unordered_map<std::string_view, AttributeKeyId> ids;
+};
+
+static KeyPool &key_pool()
+{
+  static KeyPool pool;
+  return pool;
+}
+
+// functions
+
+AttributeKeyId find_key_id(const std::string &key)
+{
+  KeyPool         &pool = key_pool();
+  std::shared_lock lock(pool.mutex);
+  auto             it = pool.ids.find(key);
+  return it == pool.ids.end() ? ATTR_INVALID_KEY_ID : it->second;
+}
+
+const std::string &get_key_string(AttributeKeyId id)
+{
+  KeyPool         &pool = key_pool();
+  std::shared_lock lock(pool.mutex);
+  return pool.strings.at(id);
+}
+
+AttributeKeyId intern_key(const std::string &key)
+{
+  AttributeKeyId id = find_key_id(key);
+
+  if (id != ATTR_INVALID_KEY_ID)
+    return id;
+
+  KeyPool         &pool = key_pool();
+  std::unique_lock lock(pool.mutex);
+
+  // may have been interned by another thread in between
+  auto it = pool.ids.find(key);
+  if (it != pool.ids.end())
+    return it->second;
+
+  id = static_cast<AttributeKeyId>(pool.strings.size());
+  pool.strings.push_back(key);
+  pool.ids[pool.strings.back()] = id;
+
+  return id;
+}
+
+AttributeSet attribute_set_view(
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map)
+{
+  AttributeSet set;
+
+  for (auto &[key, pa] : attr_map)
+    if (pa)
+      set.add_ref(key, pa.get());
+
+  return set;
+}
+
+// class definition
+
+AttributeSet::AttributeSet(
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &&attr_map)
+{
+  for (auto &[key, pa] : attr_map)
+    if (pa)
+      this->adopt(key, std::move(pa));
+
+  attr_map.clear();
+}
+
+AttributeSet::~AttributeSet() { this->clear(); }
+
+AttributeSet &AttributeSet::operator=(AttributeSet &&other)
+{
+  if (this != &other)
+  {
+    this->clear();
+
+    this->key_ids = std::move(other.key_ids);
+    this->attrs = std::move(other.attrs);
+    this->sorted = std::move(other.sorted);
+    this->arena = std::move(other.arena);
+    this->owned_attrs = std::move(other.owned_attrs);
+  }
+  return *this;
+}
+
+bool AttributeSet::add_ref(const std::string &key, AbstractAttribute *p_attr)
+{
+  AttributeKeyId id = intern_key(key);
+
+  if (this->contains(id))
+  {
+    Logger::log()->error("AttributeSet::add_ref: key {} already in use", key);
+    return false;
+  }
+
+  this->insert(id, p_attr);
+  return true;
+}
+
+bool AttributeSet::adopt(const std::string                 &key,
+                         std::unique_ptr<AbstractAttribute> p_attr)
+{
+  if (!this->add_ref(key, p_attr.get()))
+    return false;
+
+  this->owned_attrs.push_back(std::move(p_attr));
+  return true;
+}
+
+AbstractAttribute *AttributeSet::at(AttributeKeyId id) const
+{
+  AbstractAttribute *p_attr = this->find(id);
+
+  if (!p_attr)
+    throw std::out_of_range("AttributeSet::at: unknown key id");
+
+  return p_attr;
+}
+
+AbstractAttribute *AttributeSet::at(const std::string &key) const
+{
+  AbstractAttribute *p_attr = this->find(key);
+
+  if (!p_attr)
+    throw std::out_of_range("AttributeSet::at: unknown key " + key);
+
+  return p_attr;
+}
+
+void AttributeSet::clear()
+{
+  // arena attributes must be destroyed before their storage is released
+  this->owned_attrs.clear();
+  this->arena.reset();
+  this->key_ids.clear();
+  this->attrs.clear();
+  this->sorted.clear();
+}
+
+bool AttributeSet::contains(AttributeKeyId id) const { return this->find(id) != nullptr; }
+
+bool AttributeSet::contains(const std::string &key) const
+{
+  return this->find(key) != nullptr;
+}
+
+bool AttributeSet::empty() const { return this->attrs.empty(); }
+
+AbstractAttribute *AttributeSet::find(AttributeKeyId id) const
+{
+  auto it = std::lower_bound(this->sorted.begin(),
+                             this->sorted.end(),
+                             id,
+                             [](const std::pair<AttributeKeyId, uint32_t> &entry,
+                                AttributeKeyId                            value)
+                             { return entry.first < value; });
+
+  if (it == this->sorted.end() || it->first != id)
+    return nullptr;
+
+  return this->attrs[it->second];
+}
+
+AbstractAttribute *AttributeSet::find(const std::string &key) const
+{
+  AttributeKeyId id = find_key_id(key);
+  return id == ATTR_INVALID_KEY_ID ? nullptr : this->find(id);
+}
+
+const std::vector<AbstractAttribute *> &AttributeSet::get_attributes() const
+{
+  return this->attrs;
+}
+
+const std::vector<AttributeKeyId> &AttributeSet::get_key_ids() const
+{
+  return this->key_ids;
+}
+
+std::vector<std::string> AttributeSet::get_keys() const
+{
+  std::vector<std::string> keys;
+  keys.reserve(this->key_ids.size());
+
+  for (auto id : this->key_ids)
+    keys.push_back(get_key_string(id));
+
+  return keys;
+}
+
+void AttributeSet::insert(AttributeKeyId id, AbstractAttribute *p_attr)
+{
+  uint32_t index = static_cast<uint32_t>(this->attrs.size());
+
+  this->key_ids.push_back(id);
+  this->attrs.push_back(p_attr);
+
+  auto it = std::lower_bound(this->sorted.begin(),
+                             this->sorted.end(),
+                             std::make_pair(id, uint32_t(0)));
+  this->sorted.insert(it, {id, index});
+}
+
+size_t AttributeSet::size() const { return this->attrs.size(); }
+
+std::shared_ptr<const AttributesSnapshot> AttributeSet::snapshot() const
+{
+  auto p_snapshot = std::make_shared<AttributesSnapshot>();
+
+  for (size_t k = 0; k < this->attrs.size(); k++)
+    p_snapshot->add(get_key_string(this->key_ids[k]), this->attrs[k]);
+
+  return p_snapshot;
+}
+
+} // namespace attr
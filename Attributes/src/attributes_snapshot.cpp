@@ -0,0 +1,167 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include "attributes/array_attribute.hpp"
+#include "attributes/attributes_snapshot.hpp"
+#include "attributes/bool_attribute.hpp"
+#include "attributes/choice_attribute.hpp"
+#include "attributes/cloud_attribute.hpp"
+#include "attributes/color_attribute.hpp"
+#include "attributes/color_gradient_attribute.hpp"
+#include "attributes/enum_attribute.hpp"
+#include "attributes/filename_attribute.hpp"
+#include "attributes/float_attribute.hpp"
+#include "attributes/int_attribute.hpp"
+#include "attributes/path_attribute.hpp"
+#include "attributes/range_attribute.hpp"
+#include "attributes/resolution_attribute.hpp"
+#include "attributes/seed_attribute.hpp"
+#include "attributes/string_attribute.hpp"
+#include "attributes/vec2float_attribute.hpp"
+#include "attributes/vec_float_attribute.hpp"
+#include "attributes/vec_int_attribute.hpp"
+#include "attributes/wave_nb_attribute.hpp"
+
+namespace attr
+{
+
+// helpers
+
+namespace
+{
+
+// small values, copied
+template <typename A> void copy_value(AbstractAttribute *p_attr, SnapshotEntry &entry)
+{
+  using T = decltype(std::declval<A>().get_value());
+
+  entry.p_value = std::make_shared<const T>(p_attr->get_ref<A>()->get_value());
+  entry.p_type = &typeid(T);
+}
+
+// values made of several members of the attribute
+template <typename T> void make_value(const T &value, SnapshotEntry &entry)
+{
+  entry.p_value = std::make_shared<const T>(value);
+  entry.p_type = &typeid(T);
+}
+
+// large values, shared with the value published by the attribute
+template <typename A> void share_value(AbstractAttribute *p_attr, SnapshotEntry &entry)
+{
+  A *p = p_attr->get_ref<A>();
+  p->publish();
+
+  auto p_value = p->get_snapshot();
+  using T = typename decltype(p_value)::element_type;
+
+  entry.p_value = p_value;
+  entry.p_type = &typeid(T);
+}
+
+} // namespace
+
+// class definition
+
+bool AttributesSnapshot::add(const std::string &key, AbstractAttribute *p_attr)
+{
+  if (this->contains(key))
+  {
+    Logger::log()->error("AttributesSnapshot::add: key {} already in use", key);
+    return false;
+  }
+
+  SnapshotEntry entry;
+  entry.type = p_attr->get_type();
+  entry.version = p_attr->get_version();
+
+  switch (entry.type)
+  {
+  case AttributeType::BOOL: copy_value<BoolAttribute>(p_attr, entry); break;
+  case AttributeType::CHOICE: copy_value<ChoiceAttribute>(p_attr, entry); break;
+  case AttributeType::COLOR: copy_value<ColorAttribute>(p_attr, entry); break;
+  case AttributeType::COLOR_GRADIENT:
+    share_value<ColorGradientAttribute>(p_attr, entry);
+    break;
+  case AttributeType::ENUM:
+  {
+    auto *p = p_attr->get_ref<EnumAttribute>();
+    make_value(EnumSnapshot{p->get_value(), p->get_choice()}, entry);
+    break;
+  }
+  case AttributeType::FILENAME: copy_value<FilenameAttribute>(p_attr, entry); break;
+  case AttributeType::FLOAT: copy_value<FloatAttribute>(p_attr, entry); break;
+  case AttributeType::HMAP_ARRAY: share_value<ArrayAttribute>(p_attr, entry); break;
+  case AttributeType::HMAP_CLOUD: share_value<CloudAttribute>(p_attr, entry); break;
+  case AttributeType::HMAP_PATH: share_value<PathAttribute>(p_attr, entry); break;
+  case AttributeType::INT: copy_value<IntAttribute>(p_attr, entry); break;
+  case AttributeType::RANGE:
+  {
+    auto *p = p_attr->get_ref<RangeAttribute>();
+    make_value(RangeSnapshot{p->get_value(), p->get_is_active()}, entry);
+    break;
+  }
+  case AttributeType::SEED: copy_value<SeedAttribute>(p_attr, entry); break;
+  case AttributeType::STRING: copy_value<StringAttribute>(p_attr, entry); break;
+  case AttributeType::VEC_FLOAT: copy_value<VecFloatAttribute>(p_attr, entry); break;
+  case AttributeType::VEC_INT: copy_value<VecIntAttribute>(p_attr, entry); break;
+  case AttributeType::VEC2FLOAT: copy_value<Vec2FloatAttribute>(p_attr, entry); break;
+  case AttributeType::WAVE_NB: copy_value<WaveNbAttribute>(p_attr, entry); break;
+  case AttributeType::RESOLUTION:
+    copy_value<ResolutionAttribute>(p_attr, entry);
+    break;
+  default:
+    Logger::log()->error("AttributesSnapshot::add: unsupported attribute type for key {}",
+                         key);
+    return false;
+  }
+
+  this->entries.emplace(key, std::move(entry));
+  return true;
+}
+
+bool AttributesSnapshot::contains(const std::string &key) const
+{
+  return this->entries.contains(key);
+}
+
+bool AttributesSnapshot::empty() const { return this->entries.empty(); }
+
+std::vector<std::string> AttributesSnapshot::get_keys() const
+{
+  std::vector<std::string> keys;
+  keys.reserve(this->entries.size());
+
+  for (auto &[key, _] : this->entries)
+    keys.push_back(key);
+
+  return keys;
+}
+
+AttributeType AttributesSnapshot::get_type(const std::string &key) const
+{
+  return this->entries.at(key).type;
+}
+
+uint64_t AttributesSnapshot::get_version(const std::string &key) const
+{
+  return this->entries.at(key).version;
+}
+
+size_t AttributesSnapshot::size() const { return this->entries.size(); }
+
+// functions
+
+std::shared_ptr<const AttributesSnapshot> snapshot_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map)
+{
+  auto p_snapshot = std::make_shared<AttributesSnapshot>();
+
+  for (auto &[key, pa] : attr_map)
+    if (pa)
+      p_snapshot->add(key, pa.get());
+
+  return p_snapshot;
+}
+
+} // namespace attr
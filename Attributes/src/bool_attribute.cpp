@@ -2,6 +2,9 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #include "attributes/bool_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -25,28 +28,53 @@ BoolAttribute::BoolAttribute(const std::string &label,
   this->save_initial_state();
 }
 
-std::string BoolAttribute::get_label_false() const { return this->label_false; }
-std::string BoolAttribute::get_label_true() const { return this->label_true; }
+SharedString BoolAttribute::get_label_false() const { return this->label_false; }
+SharedString BoolAttribute::get_label_true() const { return this->label_true; }
 bool        BoolAttribute::get_value() const { return this->value; }
 
 void BoolAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get(json, "value", value);
-  json_safe_get(json, "label_true", label_true);
-  json_safe_get(json, "label_false", label_false);
+  ATTR_TRACE_SCOPE("BoolAttribute::json_from");
+
+  using Schema = JsonSchema<BoolAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&BoolAttribute::value>("value"),
+      Schema::member<&BoolAttribute::label_true>("label_true"),
+      Schema::member<&BoolAttribute::label_false>("label_false")};
+
+  this->bump_version();
+  schema.read(json, *this);
 }
 
 nlohmann::json BoolAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("BoolAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
-  json["value"] = this->value;
+  json["value"] = this->value.load();
   json["label_true"] = this->label_true;
   json["label_false"] = this->label_false;
   return json;
 }
 
-void BoolAttribute::set_value(const bool &new_value) { this->value = new_value; }
+uint64_t BoolAttribute::hash() const
+{
+  return hash_value(this->value.load());
+}
+
+MemoryUsage BoolAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  return usage;
+}
+
+void BoolAttribute::set_value(const bool &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 std::string BoolAttribute::to_string() { return this->value ? "true" : "false"; }
 
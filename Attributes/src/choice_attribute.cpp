@@ -5,6 +5,9 @@
 #include <stdexcept>
 
 #include "attributes/choice_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -80,30 +83,59 @@ std::string ChoiceAttribute::get_value() const { return this->value; }
 
 void ChoiceAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get(json, "value", value);
-  json_safe_get<std::vector<std::string>>(json, "choice_list", choice_list);
+  ATTR_TRACE_SCOPE("ChoiceAttribute::json_from");
+
+  using Schema = JsonSchema<ChoiceAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&ChoiceAttribute::value>("value"),
+      Schema::member<&ChoiceAttribute::choice_list>("choice_list")};
+
+  this->bump_version();
+  schema.read(json, *this);
 }
 
 nlohmann::json ChoiceAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("ChoiceAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = this->value;
   json["choice_list"] = this->choice_list;
   return json;
 }
 
+uint64_t ChoiceAttribute::hash() const
+{
+  return hash_string(this->value);
+}
+
+MemoryUsage ChoiceAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+
+  usage.value += string_memory_usage(this->value);
+  usage.metadata += vector_memory_usage(this->choice_list);
+  return usage;
+}
+
 void ChoiceAttribute::set_choice_list(const std::vector<std::string> &new_choice_list)
 {
   this->choice_list = new_choice_list;
-};
+  this->bump_version();
+}
 
 void ChoiceAttribute::set_use_combo_list(bool new_state)
 {
   this->use_combo_list = new_state;
 }
 
-void ChoiceAttribute::set_value(const std::string &new_value) { this->value = new_value; }
+void ChoiceAttribute::set_value(const std::string &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 std::string ChoiceAttribute::to_string()
 {
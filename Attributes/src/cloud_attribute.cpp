@@ -3,6 +3,10 @@
  * this software. */
 
 #include "attributes/cloud_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/json_stream.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -22,46 +26,270 @@ CloudAttribute::CloudAttribute(const std::string &label, const hmap::Cloud &valu
   this->save_initial_state();
 }
 
+ValueWriteScope<hmap::Cloud> CloudAttribute::edit_value()
+{
+  // the version is bumped when the scope ends, the buffers cached until then are
+  // outdated by the bump
+  this->make_value_primary();
+  return ValueWriteScope<hmap::Cloud>(this, &this->value);
+}
+
 std::function<QImage()> CloudAttribute::get_background_image_fct() const
 {
   return this->background_image_fct;
 }
 
+const CloudBuffers &CloudAttribute::get_buffers() const
+{
+  this->sync_buffers();
+  return this->buffers;
+}
+
+size_t CloudAttribute::get_npoints() const
+{
+  std::lock_guard<std::mutex> lock(this->cache_mutex);
+  return this->is_value_primary ? this->value.size() : this->buffers.x.size();
+}
+
+std::shared_ptr<const hmap::Cloud> CloudAttribute::get_snapshot() const
+{
+  return this->published_value.load();
+}
+
+hmap::Cloud CloudAttribute::get_value() const
+{
+  this->sync_value();
+  return this->value;
+}
+
+hmap::Cloud *CloudAttribute::get_value_ref()
+{
+  this->make_value_primary();
+
+  // the caller is given write access, consider the value as modified. The writes come
+  // after the bump, the buffers are not cached for this version (see sync_buffers)
+  std::lock_guard<std::mutex> lock(this->cache_mutex);
+  this->bump_version();
+  this->value_ref_version = this->get_version();
+  return &this->value;
+}
+
+std::span<const float> CloudAttribute::get_values() const
+{
+  return this->get_buffers().v;
+}
+
+std::span<const float> CloudAttribute::get_x() const { return this->get_buffers().x; }
+
+std::span<const float> CloudAttribute::get_y() const { return this->get_buffers().y; }
+
 void CloudAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
+  ATTR_TRACE_SCOPE("CloudAttribute::json_from");
+
+  BulkArrays bulk;
+  this->json_from_bulk(json, bulk);
+}
+
+void CloudAttribute::json_from_bulk(nlohmann::json const &json, BulkArrays &bulk)
+{
+  ATTR_TRACE_SCOPE("CloudAttribute::json_from_bulk");
 
-  std::vector<float> x = json["x"].get<std::vector<float>>();
-  std::vector<float> y = json["y"].get<std::vector<float>>();
-  std::vector<float> values = json["values"].get<std::vector<float>>();
+  using Schema = JsonSchema<CloudAttribute>;
 
-  this->value = hmap::Cloud(x, y, values);
+  // the arrays are only found in 'json' when called from json_from
+  static const Schema schema = {Schema::bulk("x"),
+                                Schema::bulk("y"),
+                                Schema::bulk("values")};
+
+  this->bump_version();
+  schema.read(json, *this, &bulk);
+  this->set_buffers(std::move(bulk["x"]),
+                    std::move(bulk["y"]),
+                    std::move(bulk["values"]));
+}
+
+std::vector<std::string> CloudAttribute::json_bulk_keys() const
+{
+  return {"x", "y", "values"};
 }
 
 nlohmann::json CloudAttribute::json_to() const
 {
-  nlohmann::json json = AbstractAttribute::json_to();
+  ATTR_TRACE_SCOPE("CloudAttribute::json_to");
+
+  nlohmann::json      json = AbstractAttribute::json_to();
+  const CloudBuffers &b = this->get_buffers();
 
-  json["x"] = this->value.get_x();
-  json["y"] = this->value.get_y();
-  json["values"] = this->value.get_values();
+  json["x"] = b.x;
+  json["y"] = b.y;
+  json["values"] = b.v;
 
   return json;
 }
 
+nlohmann::json CloudAttribute::json_to_bulk(BulkArrays &bulk) const
+{
+  ATTR_TRACE_SCOPE("CloudAttribute::json_to_bulk");
+
+  const CloudBuffers &b = this->get_buffers();
+
+  bulk["x"] = b.x;
+  bulk["y"] = b.y;
+  bulk["values"] = b.v;
+
+  return AbstractAttribute::json_to();
+}
+
+void CloudAttribute::json_write(std::ostream &os) const
+{
+  const CloudBuffers &b = this->get_buffers();
+
+  json_write_head(os, AbstractAttribute::json_to());
+  os << ",\"x\":";
+  json_write_float_array(os, b.x.size(), [&b](size_t k) { return b.x[k]; });
+  os << ",\"y\":";
+  json_write_float_array(os, b.y.size(), [&b](size_t k) { return b.y[k]; });
+  os << ",\"values\":";
+  json_write_float_array(os, b.v.size(), [&b](size_t k) { return b.v[k]; });
+  os << '}';
+}
+
+uint64_t CloudAttribute::hash() const
+{
+  const CloudBuffers &b = this->get_buffers();
+
+  uint64_t h = hash_vector(b.x);
+  h = hash_combine(h, hash_vector(b.y));
+  return hash_combine(h, hash_vector(b.v));
+}
+
+MemoryUsage CloudAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+
+  {
+    // the primary representation holds the value, the other one is a cache
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+
+    size_t buffers_size = vector_memory_usage(this->buffers.x) +
+                          vector_memory_usage(this->buffers.y) +
+                          vector_memory_usage(this->buffers.v);
+    size_t points_size = vector_memory_usage(this->value.points);
+
+    usage.value += this->is_value_primary ? points_size : buffers_size;
+    usage.cache += this->is_value_primary ? buffers_size : points_size;
+  }
+
+  if (auto p_snapshot = this->published_value.load())
+    usage.cache += sizeof(hmap::Cloud) + vector_memory_usage(p_snapshot->points);
+  return usage;
+}
+
+void CloudAttribute::publish()
+{
+  // no conversion if the published value is up to date
+  if (this->published_value.is_published(this->get_version()))
+    return;
+
+  this->sync_value();
+  this->published_value.publish(this->value, this->get_version());
+}
+
 void CloudAttribute::set_background_image_fct(std::function<QImage()> new_fct)
 {
   this->background_image_fct = new_fct;
 }
 
+void CloudAttribute::set_buffers(std::vector<float> &&x,
+                                 std::vector<float> &&y,
+                                 std::vector<float> &&v)
+{
+  if (x.size() != y.size() || x.size() != v.size())
+  {
+    Logger::log()->error("CloudAttribute::set_buffers: buffer sizes differ ({}, {}, {})",
+                         x.size(),
+                         y.size(),
+                         v.size());
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(this->cache_mutex);
+
+  this->buffers.x = std::move(x);
+  this->buffers.y = std::move(y);
+  this->buffers.v = std::move(v);
+  this->is_value_primary = false;
+  this->bump_version();
+}
+
+void CloudAttribute::set_value(const hmap::Cloud &new_value)
+{
+  std::lock_guard<std::mutex> lock(this->cache_mutex);
+
+  this->value = new_value;
+  this->is_value_primary = true;
+  this->bump_version();
+}
+
+void CloudAttribute::make_value_primary()
+{
+  this->sync_value();
+
+  // the buffers, up to date with the value, become its cache
+  std::lock_guard<std::mutex> lock(this->cache_mutex);
+  this->is_value_primary = true;
+}
+
+void CloudAttribute::sync_buffers() const
+{
+  std::lock_guard<std::mutex> lock(this->cache_mutex);
+
+  uint64_t version = this->get_version();
+
+  if (!this->is_value_primary || this->cache_version == version)
+    return;
+
+  const auto &points = this->value.points;
+
+  this->buffers.x.resize(points.size());
+  this->buffers.y.resize(points.size());
+  this->buffers.v.resize(points.size());
+
+  for (size_t k = 0; k < points.size(); k++)
+  {
+    this->buffers.x[k] = points[k].x;
+    this->buffers.y[k] = points[k].y;
+    this->buffers.v[k] = points[k].v;
+  }
+
+  // the value obtained from get_value_ref may still be written to at this version
+  this->cache_version = version == this->value_ref_version ? UINT64_MAX : version;
+}
+
+void CloudAttribute::sync_value() const
+{
+  std::lock_guard<std::mutex> lock(this->cache_mutex);
+
+  uint64_t version = this->get_version();
+
+  if (this->is_value_primary || this->cache_version == version)
+    return;
+
+  this->value = hmap::Cloud(this->buffers.x, this->buffers.y, this->buffers.v);
+  this->cache_version = version;
+}
+
 std::string CloudAttribute::to_string()
 {
-  std::string str = "";
+  const CloudBuffers &b = this->get_buffers();
+  std::string         str = "";
 
-  str += "npoints: " + std::to_string(this->value.size());
-  for (auto &p : this->value.points)
-    str += "\n(" + std::to_string(p.x) + ", " + std::to_string(p.y) + ", " +
-           std::to_string(p.v) + ")";
+  str += "npoints: " + std::to_string(b.x.size());
+  for (size_t k = 0; k < b.x.size(); k++)
+    str += "\n(" + std::to_string(b.x[k]) + ", " + std::to_string(b.y[k]) + ", " +
+           std::to_string(b.v[k]) + ")";
 
   return str;
 }
@@ -1,15 +1,20 @@
 /* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <cmath>
 
 #include "attributes/color_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 #include "attributes/widgets/color_widget.hpp"
 
 namespace attr
 {
 
 ColorAttribute::ColorAttribute(const std::string &label, const std::vector<float> &value)
-    : AbstractAttribute(AttributeType::COLOR, label), value(value)
+    : AbstractAttribute(AttributeType::COLOR, label), value(value),
+      track(value.size())
 {
   this->save_state();
   this->save_initial_state();
@@ -20,30 +25,108 @@ ColorAttribute::ColorAttribute(const std::string &label,
                                float              g,
                                float              b,
                                float              a)
-    : AbstractAttribute(AttributeType::COLOR, label), value({r, g, b, a})
+    : AbstractAttribute(AttributeType::COLOR, label), value({r, g, b, a}),
+      track(4)
 {
   this->save_state();
   this->save_initial_state();
 }
 
+void ColorAttribute::blend_value(const AbstractAttribute &a,
+                                 const AbstractAttribute &b,
+                                 float                    t)
+{
+  const std::vector<float> &va = static_cast<const ColorAttribute &>(a).value;
+  const std::vector<float> &vb = static_cast<const ColorAttribute &>(b).value;
+
+  if (va.size() != vb.size())
+  {
+    AbstractAttribute::blend_value(a, b, t);
+    return;
+  }
+
+  std::vector<float> v(va.size());
+  for (size_t k = 0; k < v.size(); k++)
+    v[k] = std::lerp(va[k], vb[k], t);
+
+  this->set_value(v);
+}
+
 std::vector<float> ColorAttribute::get_value() const { return this->value; }
 
+ValueWriteScope<KeyframeTrack> ColorAttribute::edit_track()
+{
+  return ValueWriteScope<KeyframeTrack>(this, &this->track);
+}
+
+const KeyframeTrack &ColorAttribute::get_track() const { return this->track; }
+
+std::vector<float> ColorAttribute::get_value_at(float time) const
+{
+  if (this->track.empty())
+    return this->value;
+
+  std::vector<float> out(this->track.get_ncomponents());
+  this->track.evaluate(time, out.data());
+  return out;
+}
+
+void ColorAttribute::get_values_at(std::span<const float> times, float *out) const
+{
+  // static value padded to the track components, the value size is not enforced
+  std::vector<float> v = this->value;
+  v.resize(this->track.get_ncomponents(), 1.f);
+  this->track.evaluate(times, out, v.data());
+}
+
 void ColorAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get<std::vector<float>>(json, "value", value);
+  ATTR_TRACE_SCOPE("ColorAttribute::json_from");
+
+  using Schema = JsonSchema<ColorAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&ColorAttribute::value>("value"),
+      {"keyframes",
+       [](ColorAttribute &a, const nlohmann::json &j) { a.track.json_from(j); },
+       false}};
+
+  this->bump_version();
+  this->track.clear();
+  schema.read(json, *this);
 }
 
 nlohmann::json ColorAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("ColorAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = this->value;
+
+  if (!this->track.empty())
+    json["keyframes"] = this->track.json_to();
+
   return json;
 }
 
+uint64_t ColorAttribute::hash() const
+{
+  uint64_t h = hash_vector(this->value);
+  return this->track.empty() ? h : hash_combine(h, this->track.hash());
+}
+
+MemoryUsage ColorAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  usage.value += vector_memory_usage(this->value) + this->track.memory_usage();
+  return usage;
+}
+
 void ColorAttribute::set_value(const std::vector<float> &new_value)
 {
   this->value = new_value;
+  this->bump_version();
 }
 
 std::string ColorAttribute::to_string()
@@ -1,14 +1,60 @@
 /* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <algorithm>
+#include <cmath>
 #include <random>
 
 #include "attributes/color_gradient_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 #include "attributes/widgets/color_widget.hpp"
 
 namespace attr
 {
 
+// helpers
+
+// Color of the gradient at 'position', the stops being sorted by position
+static std::array<float, 4> color_at(const std::vector<Stop> &stops, float position)
+{
+  if (stops.empty())
+    return {0.f, 0.f, 0.f, 1.f};
+
+  if (position <= stops.front().position)
+    return stops.front().color;
+
+  if (position >= stops.back().position)
+    return stops.back().color;
+
+  auto it = std::upper_bound(stops.begin(),
+                             stops.end(),
+                             position,
+                             [](float p, const Stop &s) { return p < s.position; });
+
+  const Stop &s1 = *it;
+  const Stop &s0 = *(it - 1);
+  float       u = (position - s0.position) / (s1.position - s0.position);
+
+  std::array<float, 4> color;
+  for (size_t c = 0; c < 4; c++)
+    color[c] = std::lerp(s0.color[c], s1.color[c], u);
+
+  return color;
+}
+
+static std::vector<Stop> sorted_stops(std::vector<Stop> stops)
+{
+  std::stable_sort(stops.begin(),
+                   stops.end(),
+                   [](const Stop &s0, const Stop &s1)
+                   { return s0.position < s1.position; });
+  return stops;
+}
+
+// class definition
+
 ColorGradientAttribute::ColorGradientAttribute(const std::string &label)
     : AbstractAttribute(AttributeType::COLOR_GRADIENT, label)
 {
@@ -24,33 +70,102 @@ ColorGradientAttribute::ColorGradientAttribute(const std::string       &label,
   this->save_initial_state();
 }
 
+void ColorGradientAttribute::blend_value(const AbstractAttribute &a,
+                                         const AbstractAttribute &b,
+                                         float                    t)
+{
+  const std::vector<Stop> &va = static_cast<const ColorGradientAttribute &>(a).value;
+  const std::vector<Stop> &vb = static_cast<const ColorGradientAttribute &>(b).value;
+
+  std::vector<Stop> stops;
+
+  if (va.size() == vb.size())
+  {
+    // stop by stop
+    stops.resize(va.size());
+
+    for (size_t k = 0; k < stops.size(); k++)
+    {
+      stops[k].position = std::lerp(va[k].position, vb[k].position, t);
+      for (size_t c = 0; c < 4; c++)
+        stops[k].color[c] = std::lerp(va[k].color[c], vb[k].color[c], t);
+    }
+  }
+  else
+  {
+    // both gradients resampled at the positions of all the stops
+    std::vector<Stop> sa = sorted_stops(va);
+    std::vector<Stop> sb = sorted_stops(vb);
+
+    stops = sa;
+    stops.insert(stops.end(), sb.begin(), sb.end());
+    stops = sorted_stops(stops);
+    stops.erase(std::unique(stops.begin(),
+                            stops.end(),
+                            [](const Stop &s0, const Stop &s1)
+                            { return s0.position == s1.position; }),
+                stops.end());
+
+    for (auto &s : stops)
+    {
+      std::array<float, 4> ca = color_at(sa, s.position);
+      std::array<float, 4> cb = color_at(sb, s.position);
+
+      for (size_t c = 0; c < 4; c++)
+        s.color[c] = std::lerp(ca[c], cb[c], t);
+    }
+  }
+
+  this->value = std::move(stops);
+  this->bump_version();
+}
+
 std::vector<Preset> ColorGradientAttribute::get_presets() const { return this->presets; }
 
+ValueWriteScope<std::vector<Stop>> ColorGradientAttribute::edit_value()
+{
+  return ValueWriteScope<std::vector<Stop>>(this, &this->value);
+}
+
 std::vector<Stop> ColorGradientAttribute::get_value() const { return this->value; }
 
-std::vector<Stop> *ColorGradientAttribute::get_value_ref() { return &this->value; }
+std::shared_ptr<const std::vector<Stop>> ColorGradientAttribute::get_snapshot() const
+{
+  return this->published_value.load();
+}
+
+std::vector<Stop> *ColorGradientAttribute::get_value_ref()
+{
+  // the caller is given write access, consider the value as modified
+  this->bump_version();
+  return &this->value;
+}
 
 void ColorGradientAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
+  ATTR_TRACE_SCOPE("ColorGradientAttribute::json_from");
 
-  this->value.clear();
+  using Schema = JsonSchema<ColorGradientAttribute>;
 
-  if (json.contains("value"))
-  {
-    for (const auto &j : json["value"].items())
-    {
-      if (j.value().contains("position") && j.value().contains("color"))
-      {
-        Stop s{j.value()["position"], j.value()["color"]};
-        this->value.push_back(s);
-      }
-    }
-  }
+  static const Schema schema = {
+      {"value",
+       [](ColorGradientAttribute &a, const nlohmann::json &j)
+       {
+         for (auto &stop : j)
+           if (stop.contains("position") && stop.contains("color"))
+             a.value.push_back({stop["position"], stop["color"]});
+       },
+       false}};
+
+  this->bump_version();
+  this->value.clear();
+  schema.read(json, *this);
 }
 
 nlohmann::json ColorGradientAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("ColorGradientAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
 
   for (auto &v : this->value)
@@ -61,6 +176,34 @@ nlohmann::json ColorGradientAttribute::json_to() const
   return json;
 }
 
+uint64_t ColorGradientAttribute::hash() const
+{
+  // Stop is a plain {float, std::array<float, 4>} aggregate
+  return hash_vector(this->value);
+}
+
+MemoryUsage ColorGradientAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+
+  usage.value += vector_memory_usage(this->value);
+  usage.metadata += vector_memory_usage(this->presets);
+
+  for (auto &preset : this->presets)
+    usage.metadata += string_memory_usage(preset.name) +
+                      vector_memory_usage(preset.stops);
+
+  if (auto p_snapshot = this->published_value.load())
+    usage.cache += sizeof(std::vector<Stop>) + vector_memory_usage(*p_snapshot);
+  return usage;
+}
+
+void ColorGradientAttribute::publish()
+{
+  this->published_value.publish(this->value, this->get_version());
+}
+
 void ColorGradientAttribute::set_presets(const std::vector<Preset> &new_presets)
 {
   this->presets = new_presets;
@@ -69,6 +212,7 @@ void ColorGradientAttribute::set_presets(const std::vector<Preset> &new_presets)
 void ColorGradientAttribute::set_value(const std::vector<Stop> &new_value)
 {
   this->value = new_value;
+  this->bump_version();
 }
 
 void ColorGradientAttribute::shuffle_colors()
@@ -87,6 +231,8 @@ void ColorGradientAttribute::shuffle_colors()
   // reassign shuffled colors back to value
   for (size_t i = 0; i < this->value.size(); ++i)
     this->value[i].color = colors[i];
+
+  this->bump_version();
 }
 
 std::string ColorGradientAttribute::to_string()
@@ -0,0 +1,204 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <cstring>
+
+#ifdef ATTR_HAS_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#ifdef ATTR_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include "attributes/compression.hpp"
+#include "attributes/logger.hpp"
+
+namespace attr
+{
+
+// helpers
+
+static void filter_floats(CompressionFilter filter,
+                          const float      *src,
+                          size_t            n,
+                          char             *dst)
+{
+  std::vector<uint32_t> bits(n);
+  std::memcpy(bits.data(), src, n * sizeof(float));
+
+  if (filter == CompressionFilter::DELTA_SHUFFLE)
+    for (size_t k = n; k-- > 1;)
+      bits[k] -= bits[k - 1];
+
+  // byte shuffle
+  for (size_t k = 0; k < n; ++k)
+    for (size_t b = 0; b < sizeof(float); ++b)
+      dst[b * n + k] = (char)((bits[k] >> (8 * b)) & 0xFF);
+}
+
+static void unfilter_floats(CompressionFilter filter,
+                            const char       *src,
+                            size_t            n,
+                            float            *dst)
+{
+  std::vector<uint32_t> bits(n, 0);
+
+  for (size_t b = 0; b < sizeof(float); ++b)
+    for (size_t k = 0; k < n; ++k)
+      bits[k] |= (uint32_t)(unsigned char)src[b * n + k] << (8 * b);
+
+  if (filter == CompressionFilter::DELTA_SHUFFLE)
+    for (size_t k = 1; k < n; ++k)
+      bits[k] += bits[k - 1];
+
+  std::memcpy(dst, bits.data(), n * sizeof(float));
+}
+
+// functions
+
+bool compress_floats(const CompressionSettings &settings,
+                     const float               *src,
+                     size_t                     n,
+                     std::vector<char>         &dst)
+{
+  size_t      nbytes = n * sizeof(float);
+  const char *p_input = reinterpret_cast<const char *>(src);
+
+  std::vector<char> filtered;
+  if (settings.filter != CompressionFilter::NONE)
+  {
+    filtered.resize(nbytes);
+    filter_floats(settings.filter, src, n, filtered.data());
+    p_input = filtered.data();
+  }
+
+  switch (settings.codec)
+  {
+  case CompressionCodec::NONE:
+  {
+    dst.assign(p_input, p_input + nbytes);
+    return true;
+  }
+#ifdef ATTR_HAS_LZ4
+  case CompressionCodec::LZ4:
+  {
+    if (nbytes > (size_t)LZ4_MAX_INPUT_SIZE)
+      return false;
+
+    dst.resize(LZ4_compressBound((int)nbytes));
+
+    // levels above 0 use the high compression variant
+    int size = settings.level > 0 ? LZ4_compress_HC(p_input,
+                                                    dst.data(),
+                                                    (int)nbytes,
+                                                    (int)dst.size(),
+                                                    settings.level)
+                                  : LZ4_compress_default(p_input,
+                                                         dst.data(),
+                                                         (int)nbytes,
+                                                         (int)dst.size());
+    if (size <= 0)
+      return false;
+
+    dst.resize(size);
+    return true;
+  }
+#endif
+#ifdef ATTR_HAS_ZSTD
+  case CompressionCodec::ZSTD:
+  {
+    dst.resize(ZSTD_compressBound(nbytes));
+
+    size_t size = ZSTD_compress(dst.data(),
+                                dst.size(),
+                                p_input,
+                                nbytes,
+                                settings.level > 0 ? settings.level
+                                                   : ZSTD_CLEVEL_DEFAULT);
+    if (ZSTD_isError(size))
+    {
+      Logger::log()->error("compress_floats: {}", ZSTD_getErrorName(size));
+      return false;
+    }
+
+    dst.resize(size);
+    return true;
+  }
+#endif
+  default: return false;
+  }
+}
+
+bool decompress_floats(CompressionCodec  codec,
+                       CompressionFilter filter,
+                       const char       *src,
+                       size_t            src_size,
+                       float            *dst,
+                       size_t            n)
+{
+  size_t nbytes = n * sizeof(float);
+
+  // without filter, decompress straight into the destination
+  std::vector<char> buffer;
+  char             *p_output = reinterpret_cast<char *>(dst);
+
+  if (filter != CompressionFilter::NONE)
+  {
+    buffer.resize(nbytes);
+    p_output = buffer.data();
+  }
+
+  switch (codec)
+  {
+  case CompressionCodec::NONE:
+  {
+    if (src_size != nbytes)
+      return false;
+    std::memcpy(p_output, src, nbytes);
+    break;
+  }
+#ifdef ATTR_HAS_LZ4
+  case CompressionCodec::LZ4:
+  {
+    int size = LZ4_decompress_safe(src, p_output, (int)src_size, (int)nbytes);
+    if (size != (int)nbytes)
+      return false;
+    break;
+  }
+#endif
+#ifdef ATTR_HAS_ZSTD
+  case CompressionCodec::ZSTD:
+  {
+    size_t size = ZSTD_decompress(p_output, nbytes, src, src_size);
+    if (ZSTD_isError(size) || size != nbytes)
+      return false;
+    break;
+  }
+#endif
+  default: return false;
+  }
+
+  if (filter != CompressionFilter::NONE)
+    unfilter_floats(filter, p_output, n, dst);
+
+  return true;
+}
+
+bool is_codec_available(CompressionCodec codec)
+{
+  switch (codec)
+  {
+  case CompressionCodec::NONE: return true;
+#ifdef ATTR_HAS_LZ4
+  case CompressionCodec::LZ4: return true;
+#endif
+#ifdef ATTR_HAS_ZSTD
+  case CompressionCodec::ZSTD: return true;
+#endif
+  default: return false;
+  }
+}
+
+} // namespace attr
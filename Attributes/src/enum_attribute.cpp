@@ -3,6 +3,9 @@
  * this software. */
 
 #include "attributes/enum_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -49,24 +52,57 @@ std::map<std::string, int> EnumAttribute::get_map() const { return this->map; }
 
 void EnumAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get(json, "value", value);
-  json_safe_get(json, "choice", choice);
+  ATTR_TRACE_SCOPE("EnumAttribute::json_from");
+
+  using Schema = JsonSchema<EnumAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&EnumAttribute::value>("value"),
+      Schema::member<&EnumAttribute::choice>("choice")};
+
+  this->bump_version();
+  schema.read(json, *this);
 }
 
 nlohmann::json EnumAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("EnumAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = this->value;
   json["choice"] = this->choice;
   return json;
 }
 
-void EnumAttribute::set_value(const int &new_value) { this->value = new_value; }
+uint64_t EnumAttribute::hash() const
+{
+  return hash_combine(hash_value(this->value), hash_string(this->choice));
+}
+
+MemoryUsage EnumAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+
+  usage.value += string_memory_usage(this->choice);
+
+  // red-black tree nodes: links and color, then the key / value pair
+  for (auto &[key, _] : this->map)
+    usage.metadata += 4 * sizeof(void *) + sizeof(std::pair<const std::string, int>) +
+                      string_memory_usage(key);
+  return usage;
+}
+
+void EnumAttribute::set_value(const int &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 void EnumAttribute::set_choice(const std::string &new_choice)
 {
   this->choice = new_choice;
+  this->bump_version();
 }
 
 std::string EnumAttribute::to_string() { return this->choice; }
@@ -3,6 +3,9 @@
  * this software. */
 
 #include "attributes/filename_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -26,15 +29,23 @@ std::filesystem::path FilenameAttribute::get_value() const { return this->value;
 
 void FilenameAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get<std::filesystem::path>(json, "value", value);
-  json_safe_get(json, "for_saving", for_saving);
-  json_safe_get(json, "filter", filter);
-  json_safe_get(json, "label", label);
+  ATTR_TRACE_SCOPE("FilenameAttribute::json_from");
+
+  using Schema = JsonSchema<FilenameAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&FilenameAttribute::value>("value"),
+      Schema::member<&FilenameAttribute::for_saving>("for_saving"),
+      Schema::member<&FilenameAttribute::filter>("filter")};
+
+  this->bump_version();
+  schema.read(json, *this);
 }
 
 nlohmann::json FilenameAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("FilenameAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = this->value;
   json["for_saving"] = this->for_saving;
@@ -43,9 +54,25 @@ nlohmann::json FilenameAttribute::json_to() const
   return json;
 }
 
+uint64_t FilenameAttribute::hash() const
+{
+  return hash_string(this->value.string());
+}
+
+MemoryUsage FilenameAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+
+  usage.value += string_memory_usage(this->value.native());
+  usage.metadata += string_memory_usage(this->filter);
+  return usage;
+}
+
 void FilenameAttribute::set_value(const std::filesystem::path &new_value)
 {
   this->value = new_value;
+  this->bump_version();
 }
 
 std::string FilenameAttribute::to_string() { return this->value.string(); }
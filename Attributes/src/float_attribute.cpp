@@ -1,8 +1,12 @@
 /* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <cmath>
 
 #include "attributes/float_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -20,36 +24,104 @@ FloatAttribute::FloatAttribute(const std::string &label,
   this->save_initial_state();
 }
 
+void FloatAttribute::blend_value(const AbstractAttribute &a,
+                                 const AbstractAttribute &b,
+                                 float                    t)
+{
+  float va = static_cast<const FloatAttribute &>(a).value.load();
+  float vb = static_cast<const FloatAttribute &>(b).value.load();
+  this->set_value(std::lerp(va, vb, t));
+}
+
 bool FloatAttribute::get_log_scale() const { return this->log_scale; }
 
 float FloatAttribute::get_value() const { return this->value; }
 
-std::string FloatAttribute::get_value_format() const { return this->value_format; }
+SharedString FloatAttribute::get_value_format() const
+{
+  return this->value_format.get_pattern();
+}
 
 float FloatAttribute::get_vmin() const { return this->vmin; }
 
 float FloatAttribute::get_vmax() const { return this->vmax; }
 
+ValueWriteScope<KeyframeTrack> FloatAttribute::edit_track()
+{
+  return ValueWriteScope<KeyframeTrack>(this, &this->track);
+}
+
+const KeyframeTrack &FloatAttribute::get_track() const { return this->track; }
+
+float FloatAttribute::get_value_at(float time) const
+{
+  float v = this->value.load();
+  float out;
+  this->track.evaluate(time, &out, &v);
+  return out;
+}
+
+void FloatAttribute::get_values_at(std::span<const float> times, float *out) const
+{
+  float v = this->value.load();
+  this->track.evaluate(times, out, &v);
+}
+
 void FloatAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get(json, "value", value);
-  json_safe_get(json, "vmin", vmin);
-  json_safe_get(json, "vmax", vmax);
-  json_safe_get(json, "log_scale", log_scale);
+  ATTR_TRACE_SCOPE("FloatAttribute::json_from");
+
+  using Schema = JsonSchema<FloatAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&FloatAttribute::value>("value"),
+      Schema::member<&FloatAttribute::vmin>("vmin"),
+      Schema::member<&FloatAttribute::vmax>("vmax"),
+      Schema::member<&FloatAttribute::log_scale>("log_scale"),
+      {"keyframes",
+       [](FloatAttribute &a, const nlohmann::json &j) { a.track.json_from(j); },
+       false}};
+
+  this->bump_version();
+  this->track.clear();
+  schema.read(json, *this);
 }
 
 nlohmann::json FloatAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("FloatAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
-  json["value"] = this->value;
+  json["value"] = this->value.load();
   json["vmin"] = this->vmin;
   json["vmax"] = this->vmax;
   json["log_scale"] = this->log_scale;
+
+  if (!this->track.empty())
+    json["keyframes"] = this->track.json_to();
+
   return json;
 }
 
-void FloatAttribute::set_value(const float &new_value) { this->value = new_value; }
+uint64_t FloatAttribute::hash() const
+{
+  uint64_t h = hash_value(this->value.load());
+  return this->track.empty() ? h : hash_combine(h, this->track.hash());
+}
+
+MemoryUsage FloatAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  usage.value += this->track.memory_usage();
+  return usage;
+}
+
+void FloatAttribute::set_value(const float &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 std::string FloatAttribute::to_string() { return std::to_string(this->value); }
 
@@ -1,8 +1,12 @@
 /* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <cmath>
 
 #include "attributes/int_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -19,9 +23,21 @@ IntAttribute::IntAttribute(const std::string &label,
   this->save_initial_state();
 }
 
+void IntAttribute::blend_value(const AbstractAttribute &a,
+                               const AbstractAttribute &b,
+                               float                    t)
+{
+  int va = static_cast<const IntAttribute &>(a).value.load();
+  int vb = static_cast<const IntAttribute &>(b).value.load();
+  this->set_value((int)std::lround(std::lerp((float)va, (float)vb, t)));
+}
+
 int IntAttribute::get_value() const { return this->value; }
 
-std::string IntAttribute::get_value_format() const { return this->value_format; }
+SharedString IntAttribute::get_value_format() const
+{
+  return this->value_format.get_pattern();
+}
 
 int IntAttribute::get_vmin() const { return this->vmin; }
 
@@ -29,22 +45,47 @@ int IntAttribute::get_vmax() const { return this->vmax; }
 
 void IntAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get(json, "value", value);
-  json_safe_get(json, "vmin", vmin);
-  json_safe_get(json, "vmax", vmax);
+  ATTR_TRACE_SCOPE("IntAttribute::json_from");
+
+  using Schema = JsonSchema<IntAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&IntAttribute::value>("value"),
+      Schema::member<&IntAttribute::vmin>("vmin"),
+      Schema::member<&IntAttribute::vmax>("vmax")};
+
+  this->bump_version();
+  schema.read(json, *this);
 }
 
 nlohmann::json IntAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("IntAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
-  json["value"] = this->value;
+  json["value"] = this->value.load();
   json["vmin"] = this->vmin;
   json["vmax"] = this->vmax;
   return json;
 }
 
-void IntAttribute::set_value(const int &new_value) { this->value = new_value; }
+uint64_t IntAttribute::hash() const
+{
+  return hash_value(this->value.load());
+}
+
+MemoryUsage IntAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  return usage;
+}
+
+void IntAttribute::set_value(const int &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 std::string IntAttribute::to_string() { return std::to_string(this->value); }
 
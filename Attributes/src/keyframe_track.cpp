@@ -0,0 +1,304 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cmath>
+
+#include "attributes/hash.hpp"
+#include "attributes/keyframe_track.hpp"
+#include "attributes/logger.hpp"
+
+namespace attr
+{
+
+KeyframeTrack::KeyframeTrack(size_t ncomponents, KeyframeInterpolation interpolation)
+    : ncomponents(std::max(size_t(1), ncomponents)), interpolation(interpolation)
+{
+}
+
+void KeyframeTrack::clear()
+{
+  this->times.clear();
+  this->values.clear();
+  this->tangents.clear();
+}
+
+bool KeyframeTrack::empty() const { return this->times.empty(); }
+
+void KeyframeTrack::evaluate(float time, float *out, const float *static_value) const
+{
+  this->evaluate(std::span<const float>(&time, 1), out, static_value);
+}
+
+void KeyframeTrack::evaluate(std::span<const float> times,
+                             float                 *out,
+                             const float           *static_value) const
+{
+  const size_t nc = this->ncomponents;
+  const size_t nkeys = this->times.size();
+
+  // constant value
+  if (nkeys < 2)
+  {
+    const float *v = nkeys ? this->values.data() : static_value;
+
+    for (size_t i = 0; i < times.size(); i++)
+      for (size_t c = 0; c < nc; c++)
+        out[i * nc + c] = v ? v[c] : 0.f;
+    return;
+  }
+
+  uint32_t seg[ATTR_KEYFRAME_BLOCK_SIZE];
+  float    u[ATTR_KEYFRAME_BLOCK_SIZE];
+  size_t   k = 0;
+  float    time_prev = times.empty() ? 0.f : times[0];
+
+  for (size_t i0 = 0; i0 < times.size(); i0 += ATTR_KEYFRAME_BLOCK_SIZE)
+  {
+    size_t nb = std::min(size_t(ATTR_KEYFRAME_BLOCK_SIZE), times.size() - i0);
+
+    // segment lookup
+    for (size_t i = 0; i < nb; i++)
+    {
+      // NaN times are held at the first key, like the times before it
+      float time = std::isnan(times[i0 + i]) ? this->times.front() : times[i0 + i];
+
+      k = this->find_segment(time, time >= time_prev ? k : 0);
+      time_prev = time;
+
+      float t0 = this->times[k];
+      float t1 = this->times[k + 1];
+
+      seg[i] = static_cast<uint32_t>(k);
+      u[i] = std::clamp((time - t0) / (t1 - t0), 0.f, 1.f);
+    }
+
+    // interpolation, same operations for every time of the block
+    const float *v = this->values.data();
+    float       *o = out + i0 * nc;
+
+    switch (this->interpolation)
+    {
+    case KeyframeInterpolation::STEP:
+      for (size_t i = 0; i < nb; i++)
+      {
+        size_t ks = seg[i] + (u[i] >= 1.f ? 1 : 0);
+        for (size_t c = 0; c < nc; c++)
+          o[i * nc + c] = v[ks * nc + c];
+      }
+      break;
+
+    case KeyframeInterpolation::LINEAR:
+    default:
+      for (size_t i = 0; i < nb; i++)
+      {
+        const float *v0 = v + seg[i] * nc;
+        const float *v1 = v0 + nc;
+
+        for (size_t c = 0; c < nc; c++)
+          o[i * nc + c] = v0[c] + u[i] * (v1[c] - v0[c]);
+      }
+      break;
+
+    case KeyframeInterpolation::CUBIC:
+      for (size_t i = 0; i < nb; i++)
+      {
+        const float *v0 = v + seg[i] * nc;
+        const float *v1 = v0 + nc;
+        const float *m0 = this->tangents.data() + seg[i] * nc;
+        const float *m1 = m0 + nc;
+
+        // cubic Hermite basis
+        float dt = this->times[seg[i] + 1] - this->times[seg[i]];
+        float s = u[i];
+        float s2 = s * s;
+        float s3 = s2 * s;
+        float h00 = 2.f * s3 - 3.f * s2 + 1.f;
+        float h10 = (s3 - 2.f * s2 + s) * dt;
+        float h01 = -2.f * s3 + 3.f * s2;
+        float h11 = (s3 - s2) * dt;
+
+        for (size_t c = 0; c < nc; c++)
+          o[i * nc + c] = h00 * v0[c] + h10 * m0[c] + h01 * v1[c] + h11 * m1[c];
+      }
+      break;
+    }
+  }
+}
+
+size_t KeyframeTrack::find_segment(float time, size_t k_start) const
+{
+  const size_t last = this->times.size() - 2; // last segment
+
+  // NaN included, the binary search below would run past the last segment
+  if (!(time > this->times.front()))
+    return 0;
+
+  if (time >= this->times.back())
+    return last;
+
+  // a few steps forward for close times (consecutive frames), binary search otherwise
+  size_t k = std::min(k_start, last);
+
+  if (this->times[k] <= time)
+    for (int step = 0; step < 8 && k <= last; step++, k++)
+      if (time < this->times[k + 1])
+        return k;
+
+  auto it = std::upper_bound(this->times.begin(), this->times.end(), time);
+  return static_cast<size_t>(it - this->times.begin()) - 1;
+}
+
+KeyframeInterpolation KeyframeTrack::get_interpolation() const
+{
+  return this->interpolation;
+}
+
+size_t KeyframeTrack::get_ncomponents() const { return this->ncomponents; }
+
+size_t KeyframeTrack::get_nkeys() const { return this->times.size(); }
+
+const std::vector<float> &KeyframeTrack::get_times() const { return this->times; }
+
+const std::vector<float> &KeyframeTrack::get_values() const { return this->values; }
+
+uint64_t KeyframeTrack::hash() const
+{
+  uint64_t h = hash_value(static_cast<int>(this->interpolation));
+  h = hash_combine(h, hash_vector(this->times));
+  return hash_combine(h, hash_vector(this->values));
+}
+
+void KeyframeTrack::json_from(nlohmann::json const &json)
+{
+  this->clear();
+
+  if (!json.contains("times") || !json.contains("values"))
+  {
+    Logger::log()->error("KeyframeTrack::json_from: missing keys");
+    return;
+  }
+
+  std::vector<float> new_times = json["times"].get<std::vector<float>>();
+  std::vector<float> new_values = json["values"].get<std::vector<float>>();
+
+  bool is_increasing = std::adjacent_find(new_times.begin(),
+                                          new_times.end(),
+                                          [](float a, float b) { return b <= a; }) ==
+                           new_times.end() &&
+                       std::all_of(new_times.begin(),
+                                   new_times.end(),
+                                   [](float t) { return std::isfinite(t); });
+
+  if (new_values.size() != new_times.size() * this->ncomponents || !is_increasing)
+  {
+    Logger::log()->error("KeyframeTrack::json_from: invalid keys, {} times and {} values "
+                         "for {} component(s)",
+                         new_times.size(),
+                         new_values.size(),
+                         this->ncomponents);
+    return;
+  }
+
+  int interpolation = json.value("interpolation",
+                                 static_cast<int>(KeyframeInterpolation::LINEAR));
+
+  if (interpolation < static_cast<int>(KeyframeInterpolation::STEP) ||
+      interpolation > static_cast<int>(KeyframeInterpolation::CUBIC))
+  {
+    Logger::log()->error("KeyframeTrack::json_from: unknown interpolation {}, linear "
+                         "interpolation used instead",
+                         interpolation);
+    interpolation = static_cast<int>(KeyframeInterpolation::LINEAR);
+  }
+
+  this->interpolation = static_cast<KeyframeInterpolation>(interpolation);
+  this->times = std::move(new_times);
+  this->values = std::move(new_values);
+  this->update_tangents();
+}
+
+nlohmann::json KeyframeTrack::json_to() const
+{
+  nlohmann::json json;
+  json["interpolation"] = static_cast<int>(this->interpolation);
+  json["times"] = this->times;
+  json["values"] = this->values;
+  return json;
+}
+
+size_t KeyframeTrack::memory_usage() const
+{
+  return (this->times.capacity() + this->values.capacity() + this->tangents.capacity()) *
+         sizeof(float);
+}
+
+void KeyframeTrack::remove_key(size_t index)
+{
+  if (index >= this->times.size())
+  {
+    Logger::log()->error("KeyframeTrack::remove_key: index {} out of range", index);
+    return;
+  }
+
+  const size_t nc = this->ncomponents;
+
+  this->times.erase(this->times.begin() + index);
+  this->values.erase(this->values.begin() + index * nc,
+                     this->values.begin() + (index + 1) * nc);
+  this->update_tangents();
+}
+
+void KeyframeTrack::set_interpolation(KeyframeInterpolation new_interpolation)
+{
+  this->interpolation = new_interpolation;
+}
+
+void KeyframeTrack::set_key(float time, const float *value)
+{
+  if (!std::isfinite(time))
+  {
+    Logger::log()->error("KeyframeTrack::set_key: invalid time {}", time);
+    return;
+  }
+
+  const size_t nc = this->ncomponents;
+
+  auto   it = std::lower_bound(this->times.begin(), this->times.end(), time);
+  size_t index = static_cast<size_t>(it - this->times.begin());
+
+  if (it == this->times.end() || *it != time)
+  {
+    this->times.insert(it, time);
+    this->values.insert(this->values.begin() + index * nc, nc, 0.f);
+  }
+
+  std::copy(value, value + nc, this->values.begin() + index * nc);
+  this->update_tangents();
+}
+
+void KeyframeTrack::update_tangents()
+{
+  const size_t nc = this->ncomponents;
+  const size_t nkeys = this->times.size();
+
+  this->tangents.assign(nkeys * nc, 0.f);
+
+  if (nkeys < 2)
+    return;
+
+  // centered differences, one-sided at both ends
+  for (size_t k = 0; k < nkeys; k++)
+  {
+    size_t kp = k > 0 ? k - 1 : k;
+    size_t kn = k < nkeys - 1 ? k + 1 : k;
+    float  dt = this->times[kn] - this->times[kp];
+
+    for (size_t c = 0; c < nc; c++)
+      this->tangents[k * nc + c] = (this->values[kn * nc + c] -
+                                    this->values[kp * nc + c]) /
+                                   dt;
+  }
+}
+
+} // namespace attr
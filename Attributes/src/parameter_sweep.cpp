@@ -0,0 +1,419 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+#include "attributes/float_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/int_attribute.hpp"
+#include "attributes/parameter_sweep.hpp"
+#include "attributes/range_attribute.hpp"
+#include "attributes/seed_attribute.hpp"
+
+namespace attr
+{
+
+// helpers
+
+// Sobol direction numbers (Joe and Kuo, new-joe-kuo-6.21201) of the dimensions 2 to
+// ATTR_SWEEP_SOBOL_MAX_DIM: degree s, coefficients a and initial numbers m of the
+// primitive polynomials. The first dimension is the van der Corput sequence.
+struct SobolPolynomial
+{
+  uint32_t s;
+  uint32_t a;
+  uint32_t m[6];
+};
+
+static const SobolPolynomial sobol_polynomials[ATTR_SWEEP_SOBOL_MAX_DIM - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+};
+
+using SobolDirections = std::array<std::array<uint32_t, 32>, ATTR_SWEEP_SOBOL_MAX_DIM>;
+
+static const SobolDirections &sobol_directions()
+{
+  static const SobolDirections directions = []()
+  {
+    SobolDirections v = {};
+
+    for (uint32_t k = 0; k < 32; k++)
+      v[0][k] = 1u << (31 - k);
+
+    for (size_t d = 1; d < ATTR_SWEEP_SOBOL_MAX_DIM; d++)
+    {
+      const SobolPolynomial &p = sobol_polynomials[d - 1];
+
+      for (uint32_t k = 0; k < 32; k++)
+        if (k < p.s)
+          v[d][k] = p.m[k] << (31 - k);
+        else
+        {
+          v[d][k] = v[d][k - p.s] ^ (v[d][k - p.s] >> p.s);
+          for (uint32_t j = 1; j < p.s; j++)
+            if ((p.a >> (p.s - 1 - j)) & 1)
+              v[d][k] ^= v[d][k - j];
+        }
+    }
+
+    return v;
+  }();
+
+  return directions;
+}
+
+// i-th point of the sequence (Gray code order), dimension 'dim'
+static float sobol_sample(uint64_t i, size_t dim)
+{
+  const auto &v = sobol_directions()[dim];
+  uint64_t    g = i ^ (i >> 1);
+  uint32_t    x = 0;
+
+  for (size_t k = 0; g && k < 32; k++, g >>= 1)
+    if (g & 1)
+      x ^= v[k];
+
+  return static_cast<float>(std::ldexp(static_cast<double>(x), -32));
+}
+
+// class definition
+
+ParameterSweep::ParameterSweep(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+    const std::vector<SweepAxis>                                    &axes,
+    SweepSampling                                                    sampling,
+    size_t                                                           nsamples,
+    uint64_t                                                         seed)
+    : sampling(sampling), seed(seed)
+{
+  this->base = snapshot_attributes(attr_map);
+
+  for (auto &spec : axes)
+  {
+    auto it = attr_map.find(spec.key);
+
+    if (it == attr_map.end() || !it->second)
+    {
+      Logger::log()->error("ParameterSweep: unknown key {}, axis ignored", spec.key);
+      continue;
+    }
+
+    AbstractAttribute *p_attr = it->second.get();
+    Axis               axis = {spec.key,
+                               p_attr->get_type(),
+                               0.f,
+                               0.f,
+                               std::max(1, spec.nsteps),
+                               0,
+                               true,
+                               this->ndims};
+
+    switch (axis.type)
+    {
+    case AttributeType::FLOAT:
+      axis.vmin = p_attr->get_ref<FloatAttribute>()->get_vmin();
+      axis.vmax = p_attr->get_ref<FloatAttribute>()->get_vmax();
+      break;
+    case AttributeType::INT:
+      axis.vmin = static_cast<float>(p_attr->get_ref<IntAttribute>()->get_vmin());
+      axis.vmax = static_cast<float>(p_attr->get_ref<IntAttribute>()->get_vmax());
+      break;
+    case AttributeType::RANGE:
+      axis.vmin = p_attr->get_ref<RangeAttribute>()->get_vmin();
+      axis.vmax = p_attr->get_ref<RangeAttribute>()->get_vmax();
+      break;
+    case AttributeType::SEED:
+      axis.seed_start = p_attr->get_ref<SeedAttribute>()->get_value();
+      axis.has_bounds = false;
+      break;
+    default:
+      Logger::log()->error("ParameterSweep: attribute type {} of key {} cannot be swept, "
+                           "axis ignored",
+                           p_attr->get_type_string(),
+                           spec.key);
+      continue;
+    }
+
+    if (spec.bounds)
+    {
+      axis.vmin = spec.bounds->x;
+      axis.vmax = spec.bounds->y;
+      axis.has_bounds = true;
+    }
+
+    // the values are taken from 'vmin' up (negative spans would also make the grid
+    // counts and the integer casts below meaningless)
+    if (axis.vmin > axis.vmax)
+    {
+      Logger::log()->warn("ParameterSweep: reversed bounds [{}, {}] of key {}, swapped",
+                          axis.vmin,
+                          axis.vmax,
+                          spec.key);
+      std::swap(axis.vmin, axis.vmax);
+    }
+
+    // seeds are unsigned 32-bit integers, out-of-range float to integer casts are
+    // undefined
+    if (axis.type == AttributeType::SEED && axis.has_bounds)
+    {
+      const float seed_max = std::nextafter(0x1p32f, 0.f);
+      axis.vmin = std::clamp(axis.vmin, 0.f, seed_max);
+      axis.vmax = std::clamp(axis.vmax, 0.f, seed_max);
+    }
+
+    // default bounds of the Float and Int attributes
+    bool is_unbounded = !std::isfinite(axis.vmax - axis.vmin) ||
+                        (axis.type == AttributeType::INT &&
+                         (axis.vmin <= -INT_MAX || axis.vmax >= INT_MAX));
+
+    if (axis.has_bounds && is_unbounded)
+    {
+      Logger::log()->error("ParameterSweep: attribute of key {} is unbounded, provide "
+                           "sweep bounds, axis ignored",
+                           spec.key);
+      continue;
+    }
+
+    this->ndims += axis.type == AttributeType::RANGE ? 2 : 1;
+    this->axes.push_back(axis);
+  }
+
+  if (this->sampling == SweepSampling::GRID)
+  {
+    this->nvariants = 1;
+    for (auto &axis : this->axes)
+      this->nvariants *= this->get_grid_count(axis);
+  }
+  else
+    this->nvariants = nsamples;
+
+  if (this->sampling == SweepSampling::SOBOL && this->ndims > ATTR_SWEEP_SOBOL_MAX_DIM)
+    Logger::log()->warn("ParameterSweep: {} dimensions, the ones above {} are sampled "
+                        "randomly",
+                        this->ndims,
+                        ATTR_SWEEP_SOBOL_MAX_DIM);
+}
+
+std::shared_ptr<const AttributesSnapshot> ParameterSweep::get_base() const
+{
+  return this->base;
+}
+
+size_t ParameterSweep::get_grid_count(const Axis &axis) const
+{
+  size_t n = static_cast<size_t>(axis.nsteps);
+
+  switch (axis.type)
+  {
+  case AttributeType::INT:
+  {
+    size_t nvalues = static_cast<size_t>(axis.vmax - axis.vmin) + 1;
+    return std::min(n, nvalues);
+  }
+  case AttributeType::RANGE: return n * (n + 1) / 2;
+  default: return n;
+  }
+}
+
+float ParameterSweep::get_sample(size_t index, size_t dim) const
+{
+  if (this->sampling == SweepSampling::SOBOL && dim < ATTR_SWEEP_SOBOL_MAX_DIM)
+    return sobol_sample(index + 1, dim); // the first point (the origin) is skipped
+
+  uint64_t h = hash_combine(hash_combine(this->seed, index), dim);
+  return static_cast<float>(h >> 40) * 0x1p-24f;
+}
+
+std::shared_ptr<const AttributesSnapshot> ParameterSweep::get_variant(size_t index) const
+{
+  if (index >= this->nvariants)
+    throw std::out_of_range("ParameterSweep::get_variant: index out of range");
+
+  auto p_variant = std::make_shared<AttributesSnapshot>(*this->base);
+
+  // grid indices, last axis varying fastest
+  size_t rem = index;
+
+  for (size_t k = this->axes.size(); k-- > 0;)
+  {
+    const Axis &axis = this->axes[k];
+    size_t      grid_index = 0;
+    float       u[2] = {0.f, 0.f};
+
+    if (this->sampling == SweepSampling::GRID)
+    {
+      size_t n = this->get_grid_count(axis);
+      grid_index = rem % n;
+      rem /= n;
+    }
+    else
+    {
+      u[0] = this->get_sample(index, axis.dim);
+      if (axis.type == AttributeType::RANGE)
+        u[1] = this->get_sample(index, axis.dim + 1);
+    }
+
+    this->set_axis_value(*p_variant, axis, u, grid_index);
+  }
+
+  return p_variant;
+}
+
+std::string ParameterSweep::get_variant_description(size_t index) const
+{
+  auto        p_variant = this->get_variant(index);
+  std::string str;
+
+  for (auto &axis : this->axes)
+  {
+    if (!str.empty())
+      str += ", ";
+
+    switch (axis.type)
+    {
+    case AttributeType::FLOAT:
+      str += std::format("{}={}", axis.key, p_variant->get<float>(axis.key));
+      break;
+    case AttributeType::INT:
+      str += std::format("{}={}", axis.key, p_variant->get<int>(axis.key));
+      break;
+    case AttributeType::RANGE:
+    {
+      glm::vec2 v = p_variant->get<RangeSnapshot>(axis.key).value;
+      str += std::format("{}=[{}, {}]", axis.key, v.x, v.y);
+      break;
+    }
+    case AttributeType::SEED:
+      str += std::format("{}={}", axis.key, p_variant->get<uint>(axis.key));
+      break;
+    default: break;
+    }
+  }
+
+  return str;
+}
+
+std::shared_ptr<const AttributesSnapshot> ParameterSweep::next(size_t *p_index)
+{
+  size_t index = this->next_index.fetch_add(1);
+
+  if (index >= this->nvariants)
+    return nullptr;
+
+  if (p_index)
+    *p_index = index;
+
+  return this->get_variant(index);
+}
+
+void ParameterSweep::reset() { this->next_index = 0; }
+
+void ParameterSweep::set_axis_value(AttributesSnapshot &snapshot,
+                                    const Axis         &axis,
+                                    const float        *u,
+                                    size_t              grid_index) const
+{
+  bool is_grid = this->sampling == SweepSampling::GRID;
+
+  // grid with a single step, the current value is kept
+  if (is_grid && axis.nsteps == 1)
+    return;
+
+  float span = axis.vmax - axis.vmin;
+
+  // position in [0, 1] of a grid step
+  auto grid_t = [](size_t i, size_t n) { return n > 1 ? float(i) / float(n - 1) : 0.f; };
+
+  switch (axis.type)
+  {
+  case AttributeType::FLOAT:
+  {
+    float t = is_grid ? grid_t(grid_index, axis.nsteps) : u[0];
+    snapshot.set<float>(axis.key, axis.vmin + t * span);
+    break;
+  }
+  case AttributeType::INT:
+  {
+    float value;
+
+    if (is_grid)
+      value = std::round(axis.vmin +
+                         grid_t(grid_index, this->get_grid_count(axis)) * span);
+    else
+      value = std::min(axis.vmin + std::floor(u[0] * (span + 1.f)), axis.vmax);
+
+    snapshot.set<int>(axis.key, static_cast<int>(value));
+    break;
+  }
+  case AttributeType::RANGE:
+  {
+    float t0 = u[0];
+    float t1 = u[1];
+
+    if (is_grid)
+    {
+      // pair (i, j), i <= j, from the grid index
+      size_t n = static_cast<size_t>(axis.nsteps);
+      size_t i = 0;
+      size_t j = grid_index;
+
+      while (j >= n - i)
+      {
+        j -= n - i;
+        i++;
+      }
+      j += i;
+
+      t0 = grid_t(i, n);
+      t1 = grid_t(j, n);
+    }
+
+    // the active state of the base value is kept
+    RangeSnapshot value = snapshot.get<RangeSnapshot>(axis.key);
+    value.value = {axis.vmin + std::min(t0, t1) * span,
+                   axis.vmin + std::max(t0, t1) * span};
+    snapshot.set<RangeSnapshot>(axis.key, value);
+    break;
+  }
+  case AttributeType::SEED:
+  {
+    uint value;
+
+    if (is_grid)
+      value = axis.has_bounds ? static_cast<uint>(std::round(
+                                    axis.vmin + grid_t(grid_index, axis.nsteps) * span))
+                              : axis.seed_start + static_cast<uint>(grid_index);
+    else
+      value = axis.has_bounds
+                  ? static_cast<uint>(
+                        std::min(axis.vmin + std::floor(u[0] * (span + 1.f)), axis.vmax))
+                  : static_cast<uint>(std::ldexp(static_cast<double>(u[0]), 32));
+
+    snapshot.set<uint>(axis.key, value);
+    break;
+  }
+  default: break;
+  }
+}
+
+size_t ParameterSweep::size() const { return this->nvariants; }
+
+} // namespace attr
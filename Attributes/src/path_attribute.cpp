@@ -3,6 +3,10 @@
  * this software. */
 
 #include "attributes/path_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/json_stream.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -22,25 +26,88 @@ PathAttribute::PathAttribute(const std::string &label, const hmap::Path &value)
   this->save_initial_state();
 }
 
+ValueWriteScope<hmap::Path> PathAttribute::edit_value()
+{
+  return ValueWriteScope<hmap::Path>(this, &this->value);
+}
+
 hmap::Path PathAttribute::get_value() const { return this->value; }
 
-hmap::Path *PathAttribute::get_value_ref() { return &this->value; }
+const hmap::Path &PathAttribute::get_value_cref() const { return this->value; }
+
+std::shared_ptr<const hmap::Path> PathAttribute::get_snapshot() const
+{
+  return this->published_value.load();
+}
 
-void PathAttribute::set_value(const hmap::Path &new_value) { this->value = new_value; }
+hmap::Path *PathAttribute::get_value_ref()
+{
+  // the caller is given write access, consider the value as modified
+  this->bump_version();
+  return &this->value;
+}
+
+void PathAttribute::publish()
+{
+  this->published_value.publish(this->value, this->get_version());
+}
+
+void PathAttribute::set_buffers(std::vector<float> &&x,
+                                std::vector<float> &&y,
+                                std::vector<float> &&v)
+{
+  if (x.size() != y.size() || x.size() != v.size())
+  {
+    Logger::log()->error("PathAttribute::set_buffers: buffer sizes differ ({}, {}, {})",
+                         x.size(),
+                         y.size(),
+                         v.size());
+    return;
+  }
+
+  this->value = hmap::Path(x, y, v, this->value.is_closed());
+  this->bump_version();
+}
+
+void PathAttribute::set_value(const hmap::Path &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 void PathAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
+  ATTR_TRACE_SCOPE("PathAttribute::json_from");
+
+  BulkArrays bulk;
+  this->json_from_bulk(json, bulk);
+}
+
+void PathAttribute::json_from_bulk(nlohmann::json const &json, BulkArrays &bulk)
+{
+  ATTR_TRACE_SCOPE("PathAttribute::json_from_bulk");
 
-  std::vector<float> x = json["x"].get<std::vector<float>>();
-  std::vector<float> y = json["y"].get<std::vector<float>>();
-  std::vector<float> values = json["values"].get<std::vector<float>>();
+  using Schema = JsonSchema<PathAttribute>;
 
-  this->value = hmap::Path(x, y, values);
+  // the arrays are only found in 'json' when called from json_from
+  static const Schema schema = {Schema::bulk("x"),
+                                Schema::bulk("y"),
+                                Schema::bulk("values")};
+
+  this->bump_version();
+  schema.read(json, *this, &bulk);
+  this->value = hmap::Path(bulk["x"], bulk["y"], bulk["values"]);
+}
+
+std::vector<std::string> PathAttribute::json_bulk_keys() const
+{
+  return {"x", "y", "values"};
 }
 
 nlohmann::json PathAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("PathAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
 
   json["x"] = this->value.get_x();
@@ -50,6 +117,62 @@ nlohmann::json PathAttribute::json_to() const
   return json;
 }
 
+nlohmann::json PathAttribute::json_to_bulk(BulkArrays &bulk) const
+{
+  ATTR_TRACE_SCOPE("PathAttribute::json_to_bulk");
+
+  bulk["x"] = this->value.get_x();
+  bulk["y"] = this->value.get_y();
+  bulk["values"] = this->value.get_values();
+
+  return AbstractAttribute::json_to();
+}
+
+void PathAttribute::json_write(std::ostream &os) const
+{
+  const auto &points = this->value.points;
+
+  json_write_head(os, AbstractAttribute::json_to());
+  os << ",\"x\":";
+  json_write_float_array(os, points.size(), [&points](size_t k) { return points[k].x; });
+  os << ",\"y\":";
+  json_write_float_array(os, points.size(), [&points](size_t k) { return points[k].y; });
+  os << ",\"values\":";
+  json_write_float_array(os, points.size(), [&points](size_t k) { return points[k].v; });
+  os << '}';
+}
+
+uint64_t PathAttribute::hash() const
+{
+  // contiguous buffers, hashed in bulk
+  const size_t       n = this->value.points.size();
+  std::vector<float> x(n), y(n), v(n);
+
+  for (size_t k = 0; k < n; k++)
+  {
+    x[k] = this->value.points[k].x;
+    y[k] = this->value.points[k].y;
+    v[k] = this->value.points[k].v;
+  }
+
+  uint64_t h = hash_value(this->value.is_closed());
+  h = hash_combine(h, hash_vector(x));
+  h = hash_combine(h, hash_vector(y));
+  return hash_combine(h, hash_vector(v));
+}
+
+MemoryUsage PathAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+
+  usage.value += vector_memory_usage(this->value.points);
+
+  if (auto p_snapshot = this->published_value.load())
+    usage.cache += sizeof(hmap::Path) + vector_memory_usage(p_snapshot->points);
+  return usage;
+}
+
 std::string PathAttribute::to_string()
 {
   std::string str = "";
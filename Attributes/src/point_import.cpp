@@ -0,0 +1,212 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+
+#include <QFile>
+
+#include "attributes/point_import.hpp"
+
+namespace attr
+{
+
+// helpers
+
+static bool is_separator(char c)
+{
+  return c == ',' || c == ';' || c == ' ' || c == '\t' || c == '\r';
+}
+
+// Parse up to 3 floats from a line, returns the number of values read or -1 if the line
+// contains something else.
+static int parse_csv_line(const char *p, const char *end, float values[3])
+{
+  int n = 0;
+
+  while (true)
+  {
+    while (p < end && is_separator(*p))
+      p++;
+
+    if (p == end)
+      return n;
+
+    if (n == 3)
+      return -1;
+
+    if (*p == '+') // not accepted by from_chars
+      p++;
+
+    auto [ptr, ec] = std::from_chars(p, end, values[n]);
+    if (ec != std::errc() || (ptr < end && !is_separator(*ptr)))
+      return -1;
+
+    p = ptr;
+    n++;
+  }
+}
+
+// functions
+
+bool import_points(const std::string     &fname,
+                   CloudBuffers          &buffers,
+                   PointImportProgressFct progress_fct)
+{
+  QFile file(QString::fromStdString(fname));
+
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    Logger::log()->error("import_points: could not open file {}", fname);
+    return false;
+  }
+
+  std::string ext = std::filesystem::path(fname).extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+  if (file.size() == 0)
+  {
+    buffers = CloudBuffers();
+    return true;
+  }
+
+  uchar *p_data = file.map(0, file.size());
+
+  if (!p_data)
+  {
+    Logger::log()->error("import_points: could not map file {}", fname);
+    return false;
+  }
+
+  std::string_view data(reinterpret_cast<const char *>(p_data), file.size());
+
+  bool ret = ext == ".bin" ? import_points_binary(data, buffers, progress_fct)
+                           : import_points_csv(data, buffers, progress_fct);
+
+  file.unmap(p_data);
+  return ret;
+}
+
+bool import_points_binary(std::string_view       data,
+                          CloudBuffers          &buffers,
+                          PointImportProgressFct progress_fct)
+{
+  const size_t record_size = 3 * sizeof(float);
+
+  if (data.size() % record_size != 0)
+  {
+    Logger::log()->error("import_points_binary: size {} is not a multiple of {} bytes",
+                         data.size(),
+                         record_size);
+    return false;
+  }
+
+  size_t       npoints = data.size() / record_size;
+  size_t       step = ATTR_IMPORT_PROGRESS_STEP / record_size; // in points
+  CloudBuffers b;
+
+  b.x.resize(npoints);
+  b.y.resize(npoints);
+  b.v.resize(npoints);
+
+  for (size_t k = 0; k < npoints; k++)
+  {
+    float record[3];
+    std::memcpy(record, data.data() + k * record_size, record_size);
+
+    b.x[k] = record[0];
+    b.y[k] = record[1];
+    b.v[k] = record[2];
+
+    if (progress_fct && (k + 1) % step == 0 && !progress_fct(float(k + 1) / npoints))
+    {
+      Logger::log()->trace("import_points_binary: canceled");
+      return false;
+    }
+  }
+
+  if (progress_fct)
+    progress_fct(1.f);
+
+  buffers = std::move(b);
+  return true;
+}
+
+bool import_points_csv(std::string_view       data,
+                       CloudBuffers          &buffers,
+                       PointImportProgressFct progress_fct)
+{
+  const char *begin = data.data();
+  const char *end = begin + data.size();
+
+  // one point per line at most, avoids reallocations
+  size_t       nlines = std::count(begin, end, '\n') + 1;
+  CloudBuffers b;
+
+  b.x.reserve(nlines);
+  b.y.reserve(nlines);
+  b.v.reserve(nlines);
+
+  bool   header_skipped = false;
+  size_t line_number = 0;
+  size_t next_progress = ATTR_IMPORT_PROGRESS_STEP;
+
+  for (const char *p = begin; p < end;)
+  {
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (!eol)
+      eol = end;
+
+    line_number++;
+
+    const char *first = p;
+    while (first < eol && is_separator(*first))
+      first++;
+
+    if (first < eol && *first != '#')
+    {
+      float values[3] = {0.f, 0.f, 0.f};
+      int   n = parse_csv_line(first, eol, values);
+
+      if (n >= 2)
+      {
+        b.x.push_back(values[0]);
+        b.y.push_back(values[1]);
+        b.v.push_back(values[2]);
+      }
+      else if (b.x.empty() && !header_skipped)
+        header_skipped = true;
+      else
+      {
+        Logger::log()->error("import_points_csv: invalid point at line {}: \"{}\"",
+                             line_number,
+                             std::string_view(first, eol - first));
+        return false;
+      }
+    }
+
+    p = eol + 1;
+
+    size_t nparsed = std::min(p, end) - begin;
+
+    if (progress_fct && nparsed >= next_progress)
+    {
+      if (!progress_fct(float(nparsed) / data.size()))
+      {
+        Logger::log()->trace("import_points_csv: canceled");
+        return false;
+      }
+      next_progress += ATTR_IMPORT_PROGRESS_STEP;
+    }
+  }
+
+  if (progress_fct)
+    progress_fct(1.f);
+
+  buffers = std::move(b);
+  return true;
+}
+
+} // namespace attr
@@ -0,0 +1,655 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "attributes/json_stream.hpp"
+#include "attributes/preset_archive.hpp"
+
+namespace attr
+{
+
+// helpers
+
+static const char     archive_magic[8] = {'A', 'T', 'T', 'R', 'P', 'R', 'S', 'T'};
+static const uint32_t archive_byte_order_mark = 0x01020304;
+
+struct ArchiveHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t byte_order_mark;
+  uint64_t index_offset;
+  uint64_t index_size;
+  uint64_t count;
+};
+
+// Bulk members by attribute type, used when converting a JSON preset without the
+// attribute instances at hand (mirrors the json_bulk_keys overrides).
+std::vector<std::string> archive_bulk_keys(AttributeType type)
+{
+  switch (type)
+  {
+  case AttributeType::HMAP_ARRAY: return {"vector"};
+  case AttributeType::HMAP_CLOUD:
+  case AttributeType::HMAP_PATH: return {"x", "y", "values"};
+  default: return {};
+  }
+}
+
+// Sequential writer: payloads are streamed as they come, the index is accumulated and
+// written at the end, then the header is patched with its location.
+class ArchiveWriter
+{
+public:
+  ArchiveWriter(const std::string &fname) : fname(fname)
+  {
+    this->file.open(fname, std::ios::binary);
+
+    ArchiveHeader header = {};
+    this->file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    this->pos = sizeof(header);
+  }
+
+  bool is_open() const { return this->file.is_open(); }
+
+  void add(const std::string         &key,
+           AttributeType              type,
+           const std::string         &json_str,
+           const BulkArrays          &bulk,
+           const CompressionSettings &compression = {})
+  {
+    this->write_pod((uint32_t)key.size());
+    this->index.append(key);
+    this->write_pod((uint32_t)type);
+
+    this->align();
+    this->write_pod(this->pos);
+    this->write_pod((uint64_t)json_str.size());
+    this->write_bytes(json_str.data(), json_str.size());
+
+    this->write_pod((uint32_t)bulk.size());
+
+    for (auto &[name, vec] : bulk)
+    {
+      CompressionCodec  codec = compression.codec;
+      CompressionFilter filter = compression.filter;
+      std::vector<char> compressed;
+
+      if (codec != CompressionCodec::NONE && !is_codec_available(codec))
+      {
+        Logger::log()->warn("Compression codec {} not available, data stored "
+                            "uncompressed",
+                            (uint32_t)codec);
+        codec = CompressionCodec::NONE;
+      }
+
+      // keep the compressed data only if it actually saves space
+      if (codec != CompressionCodec::NONE &&
+          (!compress_floats({codec, filter, compression.level},
+                            vec.data(),
+                            vec.size(),
+                            compressed) ||
+           compressed.size() >= vec.size() * sizeof(float)))
+        codec = CompressionCodec::NONE;
+
+      if (codec == CompressionCodec::NONE)
+        filter = CompressionFilter::NONE;
+
+      const void *ptr = codec == CompressionCodec::NONE ? (const void *)vec.data()
+                                                        : compressed.data();
+      uint64_t    size = codec == CompressionCodec::NONE ? vec.size() * sizeof(float)
+                                                         : compressed.size();
+
+      this->align();
+      this->write_pod((uint32_t)name.size());
+      this->index.append(name);
+      this->write_pod(this->pos);
+      this->write_pod((uint64_t)vec.size());
+      this->write_pod((uint32_t)codec);
+      this->write_pod((uint32_t)filter);
+      this->write_pod(size);
+      this->write_bytes(ptr, size);
+    }
+
+    this->count++;
+  }
+
+  bool finish()
+  {
+    ArchiveHeader header = {};
+    std::memcpy(header.magic, archive_magic, sizeof(archive_magic));
+    header.version = ATTR_ARCHIVE_VERSION;
+    header.byte_order_mark = archive_byte_order_mark;
+    header.index_offset = this->pos;
+    header.index_size = this->index.size();
+    header.count = this->count;
+
+    this->file.write(this->index.data(), this->index.size());
+    this->file.seekp(0);
+    this->file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    this->file.close();
+
+    if (this->file.fail())
+    {
+      Logger::log()->error("Could not write binary preset to file {}", this->fname);
+      return false;
+    }
+
+    Logger::log()->trace("Binary preset successfully saved to {}", this->fname);
+    return true;
+  }
+
+private:
+  std::string   fname;
+  std::ofstream file;
+  uint64_t      pos = 0;
+  uint64_t      count = 0;
+  std::string   index;
+
+  // pad the payload section to the next aligned offset
+  void align()
+  {
+    static const char zeros[ATTR_ARCHIVE_ALIGNMENT] = {};
+    uint64_t          rem = this->pos % ATTR_ARCHIVE_ALIGNMENT;
+    this->write_bytes(zeros, rem ? ATTR_ARCHIVE_ALIGNMENT - rem : 0);
+  }
+
+  void write_bytes(const void *ptr, size_t n)
+  {
+    this->file.write(static_cast<const char *>(ptr), n);
+    this->pos += n;
+  }
+
+  // index fields
+  template <typename T> void write_pod(const T &v)
+  {
+    this->index.append(reinterpret_cast<const char *>(&v), sizeof(T));
+  }
+};
+
+// Bounds-checked sequential reader for the index
+struct ArchiveCursor
+{
+  const char *ptr;
+  const char *end;
+
+  template <typename T> bool read(T &v)
+  {
+    if (this->end - this->ptr < (std::ptrdiff_t)sizeof(T))
+      return false;
+    std::memcpy(&v, this->ptr, sizeof(T));
+    this->ptr += sizeof(T);
+    return true;
+  }
+
+  bool read_string(std::string &s)
+  {
+    uint32_t n;
+    if (!this->read(n) || this->end - this->ptr < (std::ptrdiff_t)n)
+      return false;
+    s.assign(this->ptr, n);
+    this->ptr += n;
+    return true;
+  }
+};
+
+// class definition
+
+PresetArchive::PresetArchive(const std::string &fname) { this->open(fname); }
+
+PresetArchive::~PresetArchive() { this->close(); }
+
+void PresetArchive::close()
+{
+#ifndef _WIN32
+  if (this->is_mapped && this->data)
+    munmap(const_cast<char *>(this->data), this->size);
+#endif
+
+  this->data = nullptr;
+  this->size = 0;
+  this->is_mapped = false;
+  this->buffer.clear();
+  this->buffer.shrink_to_fit();
+  this->index.clear();
+}
+
+bool PresetArchive::contains(const std::string &key) const
+{
+  return this->index.contains(key);
+}
+
+nlohmann::json PresetArchive::get_json(const std::string &key) const
+{
+  auto it = this->index.find(key);
+  if (it == this->index.end())
+    return nlohmann::json();
+
+  const PresetArchiveEntry &e = it->second;
+
+  nlohmann::json json = nlohmann::json::parse(this->data + e.json_offset,
+                                              this->data + e.json_offset + e.json_length,
+                                              nullptr,
+                                              false);
+
+  if (json.is_discarded())
+  {
+    Logger::log()->error("PresetArchive::get_json: corrupted data for attribute key {}",
+                         key);
+    return nlohmann::json();
+  }
+
+  for (auto &b : e.bulk)
+  {
+    std::vector<float> vec;
+    if (!this->read_bulk(b, vec))
+      return nlohmann::json();
+    json[b.name] = vec;
+  }
+
+  return json;
+}
+
+std::vector<std::string> PresetArchive::get_keys() const
+{
+  std::vector<std::string> keys;
+  for (auto &[key, _] : this->index)
+    keys.push_back(key);
+  return keys;
+}
+
+AttributeType PresetArchive::get_type(const std::string &key) const
+{
+  auto it = this->index.find(key);
+  return it == this->index.end() ? AttributeType::INVALID : it->second.type;
+}
+
+bool PresetArchive::is_open() const { return this->data != nullptr; }
+
+bool PresetArchive::json_write(const std::string &key, std::ostream &os) const
+{
+  auto it = this->index.find(key);
+  if (it == this->index.end())
+    return false;
+
+  const PresetArchiveEntry &e = it->second;
+
+  if (e.bulk.empty())
+  {
+    os.write(this->data + e.json_offset, e.json_length);
+    return true;
+  }
+
+  // drop the closing brace of the JSON head and append the bulk members
+  os.write(this->data + e.json_offset, e.json_length - 1);
+
+  for (auto &b : e.bulk)
+  {
+    const float       *p = reinterpret_cast<const float *>(this->data + b.offset);
+    std::vector<float> vec;
+
+    if (b.codec != CompressionCodec::NONE)
+    {
+      if (!this->read_bulk(b, vec))
+        return false;
+      p = vec.data();
+    }
+
+    os << ',' << nlohmann::json(b.name).dump() << ':';
+    json_write_float_array(os, b.count, [p](size_t k) { return p[k]; });
+  }
+
+  os << '}';
+  return true;
+}
+
+bool PresetArchive::load(const std::string &key, AbstractAttribute *p_attr) const
+{
+  auto it = this->index.find(key);
+
+  if (it == this->index.end() || !p_attr)
+  {
+    Logger::log()->error("Could not load preset for parameter: {}", key);
+    return false;
+  }
+
+  const PresetArchiveEntry &e = it->second;
+
+  if (e.type != p_attr->get_type())
+  {
+    Logger::log()->error("PresetArchive::load: type mismatch for attribute key {}", key);
+    return false;
+  }
+
+  nlohmann::json json = nlohmann::json::parse(this->data + e.json_offset,
+                                              this->data + e.json_offset + e.json_length,
+                                              nullptr,
+                                              false);
+
+  if (json.is_discarded())
+  {
+    Logger::log()->error("PresetArchive::load: corrupted data for attribute key {}", key);
+    return false;
+  }
+
+  BulkArrays bulk;
+  for (auto &b : e.bulk)
+    if (!this->read_bulk(b, bulk[b.name]))
+    {
+      Logger::log()->error("PresetArchive::load: could not decode {}, attribute key {}",
+                           b.name,
+                           key);
+      return false;
+    }
+
+  p_attr->json_from_bulk(json, bulk);
+  return true;
+}
+
+bool PresetArchive::load(
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map) const
+{
+  bool ret = true;
+  for (auto &[key, pa] : attr_map)
+    ret &= this->load(key, pa.get());
+  return ret;
+}
+
+bool PresetArchive::open(const std::string &fname)
+{
+  this->close();
+  this->fname = fname;
+
+#ifndef _WIN32
+  int fd = ::open(fname.c_str(), O_RDONLY);
+  if (fd >= 0)
+  {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      void *ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptr != MAP_FAILED)
+      {
+        this->data = static_cast<const char *>(ptr);
+        this->size = (size_t)st.st_size;
+        this->is_mapped = true;
+      }
+    }
+    ::close(fd);
+  }
+#endif
+
+  // fallback, read the whole file
+  if (!this->data)
+  {
+    std::ifstream file(fname, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open())
+    {
+      Logger::log()->error("Could not open file {} to load binary preset", fname);
+      return false;
+    }
+
+    this->buffer.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read(this->buffer.data(), this->buffer.size());
+
+    this->data = this->buffer.data();
+    this->size = this->buffer.size();
+  }
+
+  if (!this->read_index())
+  {
+    Logger::log()->error("Invalid or corrupted binary preset file {}", fname);
+    this->close();
+    return false;
+  }
+
+  return true;
+}
+
+bool PresetArchive::read_bulk(const PresetArchiveBulk &b, std::vector<float> &vec) const
+{
+  if (b.codec == CompressionCodec::NONE)
+  {
+    // payloads are 64-byte aligned within a page-aligned mapping
+    const float *p = reinterpret_cast<const float *>(this->data + b.offset);
+    vec.assign(p, p + b.count);
+    return true;
+  }
+
+  vec.resize(b.count);
+  return decompress_floats(b.codec,
+                           b.filter,
+                           this->data + b.offset,
+                           b.size,
+                           vec.data(),
+                           b.count);
+}
+
+bool PresetArchive::read_index()
+{
+  ArchiveHeader header;
+
+  if (this->size < sizeof(header))
+    return false;
+
+  std::memcpy(&header, this->data, sizeof(header));
+
+  if (std::memcmp(header.magic, archive_magic, sizeof(archive_magic)) != 0 ||
+      header.version < 1 || header.version > ATTR_ARCHIVE_VERSION ||
+      header.byte_order_mark != archive_byte_order_mark ||
+      header.index_offset > this->size ||
+      header.index_size > this->size - header.index_offset)
+    return false;
+
+  ArchiveCursor cursor = {this->data + header.index_offset,
+                          this->data + header.index_offset + header.index_size};
+
+  // payload bounds check
+  auto is_valid = [this](uint64_t offset, uint64_t length)
+  { return offset <= this->size && length <= this->size - offset; };
+
+  for (uint64_t k = 0; k < header.count; ++k)
+  {
+    std::string        key;
+    uint32_t           type, nbulk;
+    PresetArchiveEntry e;
+
+    if (!cursor.read_string(key) || !cursor.read(type) || !cursor.read(e.json_offset) ||
+        !cursor.read(e.json_length) || !cursor.read(nbulk) ||
+        !is_valid(e.json_offset, e.json_length))
+      return false;
+
+    // the bulk members are spliced before the closing brace of the JSON head (see
+    // json_write), which is at least "{}"
+    if (nbulk > 0 &&
+        (e.json_length < 2 || this->data[e.json_offset + e.json_length - 1] != '}'))
+      return false;
+
+    if (type >= static_cast<uint32_t>(AttributeType::INVALID))
+      return false;
+
+    e.type = (AttributeType)type;
+
+    for (uint32_t i = 0; i < nbulk; ++i)
+    {
+      PresetArchiveBulk b;
+
+      if (!cursor.read_string(b.name) || !cursor.read(b.offset) ||
+          !cursor.read(b.count) || b.count > ATTR_ARCHIVE_MAX_BULK_COUNT)
+        return false;
+
+      b.size = b.count * sizeof(float);
+
+      // version 1 has no compression
+      if (header.version >= 2 &&
+          (!cursor.read(b.codec) || !cursor.read(b.filter) || !cursor.read(b.size)))
+        return false;
+
+      // raw floats are read in place (see read_bulk), the data are mapped page-aligned
+      // or copied to an allocation aligned for any scalar type
+      if (!is_valid(b.offset, b.size) || b.offset % alignof(float) != 0 ||
+          (b.codec == CompressionCodec::NONE && b.size != b.count * sizeof(float)) ||
+          (b.codec == CompressionCodec::LZ4 &&
+           b.count * sizeof(float) > ATTR_ARCHIVE_LZ4_MAX_RATIO * b.size + 16))
+        return false;
+
+      e.bulk.push_back(b);
+    }
+
+    this->index[key] = e;
+  }
+
+  return true;
+}
+
+// functions
+
+bool preset_archive_to_json(const std::string &archive_fname,
+                            const std::string &json_fname)
+{
+  PresetArchive archive(archive_fname);
+  if (!archive.is_open())
+    return false;
+
+  std::ofstream file(json_fname, std::ios::binary);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("Could not open file {} to save JSON", json_fname);
+    return false;
+  }
+
+  // same layout as write_preset, bulk data are streamed from the mapping
+  file << '{';
+
+  bool first = true;
+  for (auto &key : archive.get_keys())
+  {
+    file << (first ? "\n" : ",\n");
+    file << nlohmann::json(key).dump() << ':';
+    archive.json_write(key, file);
+    first = false;
+  }
+
+  file << "\n}\n";
+  file.close();
+
+  if (file.fail())
+  {
+    Logger::log()->error("Could not write preset to file {}", json_fname);
+    return false;
+  }
+
+  return true;
+}
+
+bool preset_json_to_archive(const std::string         &json_fname,
+                            const std::string         &archive_fname,
+                            const CompressionSettings &compression)
+{
+  std::ifstream file(json_fname);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("Could not open file {} to load JSON", json_fname);
+    return false;
+  }
+
+  nlohmann::json preset = nlohmann::json::parse(file, nullptr, false);
+
+  if (!preset.is_object())
+  {
+    Logger::log()->error("Invalid JSON preset {}", json_fname);
+    return false;
+  }
+
+  return save_preset_archive_json(archive_fname, std::move(preset), compression);
+}
+
+bool save_preset_archive(
+    const std::string                                               &fname,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+    const CompressionSettings                                       &compression,
+    const std::map<std::string, CompressionSettings>                &key_compression)
+{
+  ArchiveWriter writer(fname);
+
+  if (!writer.is_open())
+  {
+    Logger::log()->error("Could not open file {} to save binary preset", fname);
+    return false;
+  }
+
+  for (auto &[key, pa] : attr_map)
+  {
+    if (!pa)
+      continue;
+
+    BulkArrays     bulk;
+    nlohmann::json json = pa->json_to_bulk(bulk);
+    auto it = key_compression.find(key);
+    writer.add(key,
+               pa->get_type(),
+               json.dump(),
+               bulk,
+               it == key_compression.end() ? compression : it->second);
+  }
+
+  return writer.finish();
+}
+
+bool save_preset_archive_json(const std::string         &fname,
+                              nlohmann::json             preset,
+                              const CompressionSettings &compression)
+{
+  if (!preset.is_object())
+  {
+    Logger::log()->error("Invalid JSON preset, cannot save binary preset {}", fname);
+    return false;
+  }
+
+  ArchiveWriter writer(fname);
+
+  if (!writer.is_open())
+  {
+    Logger::log()->error("Could not open file {} to save binary preset", fname);
+    return false;
+  }
+
+  for (auto &[key, json] : preset.items())
+  {
+    AttributeType type = json.value("type", AttributeType::INVALID);
+    BulkArrays    bulk;
+
+    for (auto &name : archive_bulk_keys(type))
+      if (json.contains(name) && json[name].is_array())
+      {
+        std::vector<float> &vec = bulk[name];
+        vec.reserve(json[name].size());
+
+        // null values stand for non-finite numbers
+        for (auto &v : json[name])
+          vec.push_back(v.is_number() ? v.get<float>() : std::nanf(""));
+
+        json.erase(name);
+      }
+
+    writer.add(key, type, json.dump(), bulk, compression);
+  }
+
+  return writer.finish();
+}
+
+} // namespace attr
@@ -0,0 +1,387 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <cmath>
+#include <fstream>
+#include <set>
+
+#include "attributes/preset_io.hpp"
+#include "attributes/trace.hpp"
+
+namespace attr
+{
+
+// helpers
+
+// SAX handler dispatching the preset members to the attributes. The members of each
+// attribute object are gathered in a small JSON tree, except for the float arrays
+// flagged as bulk data by the attribute which are pushed straight into BulkArrays.
+class PresetSaxHandler : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+  PresetSaxHandler(std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+                   std::function<void(const std::string &)> post_load_fct)
+      : attr_map(attr_map), post_load_fct(post_load_fct)
+  {
+  }
+
+  bool null() override
+  {
+    if (this->p_bulk)
+    {
+      this->p_bulk->push_back(std::nanf(""));
+      return true;
+    }
+    return this->add_value(nullptr);
+  }
+
+  bool boolean(bool val) override { return this->add_value(val); }
+
+  bool number_integer(number_integer_t val) override
+  {
+    if (this->p_bulk)
+    {
+      this->p_bulk->push_back((float)val);
+      return true;
+    }
+    return this->add_value(val);
+  }
+
+  bool number_unsigned(number_unsigned_t val) override
+  {
+    if (this->p_bulk)
+    {
+      this->p_bulk->push_back((float)val);
+      return true;
+    }
+    return this->add_value(val);
+  }
+
+  bool number_float(number_float_t val, const string_t & /* s */) override
+  {
+    if (this->p_bulk)
+    {
+      this->p_bulk->push_back((float)val);
+      return true;
+    }
+    return this->add_value(val);
+  }
+
+  bool string(string_t &val) override { return this->add_value(val); }
+
+  bool binary(binary_t &val) override { return this->add_value(val); }
+
+  bool start_object(std::size_t /* elements */) override
+  {
+    if (this->p_bulk)
+      return this->bulk_error();
+
+    if (this->skip_depth == 0 && this->stack.empty())
+    {
+      // root object or attribute object
+      if (this->in_root)
+        return this->start_attribute();
+
+      this->in_root = true;
+      return true;
+    }
+
+    return this->start_container(nlohmann::json::object());
+  }
+
+  bool key(string_t &val) override
+  {
+    if (this->skip_depth > 0)
+      return true;
+
+    if (this->stack.empty())
+      this->attr_key = val; // root level
+    else
+    {
+      this->member_key = val;
+      this->is_bulk_member = this->stack.size() == 1 && this->bulk_keys.contains(val);
+    }
+
+    return true;
+  }
+
+  bool end_object() override
+  {
+    if (this->skip_depth > 0)
+    {
+      this->skip_depth--;
+      return true;
+    }
+
+    if (this->stack.empty())
+      return true; // root object
+
+    this->stack.pop_back();
+
+    if (this->stack.empty())
+      this->end_attribute();
+
+    return true;
+  }
+
+  bool start_array(std::size_t /* elements */) override
+  {
+    if (this->p_bulk)
+      return this->bulk_error();
+
+    if (this->is_bulk_member && this->skip_depth == 0)
+    {
+      this->p_bulk = &this->bulk[this->member_key];
+      this->p_bulk->clear();
+      this->is_bulk_member = false;
+      return true;
+    }
+
+    return this->start_container(nlohmann::json::array());
+  }
+
+  bool end_array() override
+  {
+    if (this->p_bulk)
+    {
+      this->p_bulk = nullptr;
+      return true;
+    }
+
+    if (this->skip_depth > 0)
+    {
+      this->skip_depth--;
+      return true;
+    }
+
+    if (!this->stack.empty())
+      this->stack.pop_back();
+
+    return true;
+  }
+
+  bool parse_error(std::size_t                        position,
+                   const std::string                 &last_token,
+                   const nlohmann::detail::exception &ex) override
+  {
+    Logger::log()->error("read_preset: JSON parse error at byte {} (last token: {}): {}",
+                         position,
+                         last_token,
+                         ex.what());
+    return false;
+  }
+
+private:
+  std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map;
+  std::function<void(const std::string &)>                   post_load_fct;
+
+  bool in_root = false;
+  int  skip_depth = 0; // containers opened within an ignored attribute
+
+  // current attribute
+  AbstractAttribute            *p_attr = nullptr;
+  std::string                   attr_key;
+  std::string                   member_key;
+  std::set<std::string>         bulk_keys;
+  bool                          is_bulk_member = false;
+  std::vector<float>           *p_bulk = nullptr;
+  nlohmann::json                head;
+  BulkArrays                    bulk;
+  std::vector<nlohmann::json *> stack;
+
+  bool add_value(nlohmann::json &&val)
+  {
+    this->is_bulk_member = false;
+
+    if (this->skip_depth > 0 || this->stack.empty())
+      return true; // ignored or root level scalar
+
+    nlohmann::json &top = *this->stack.back();
+
+    if (top.is_array())
+      top.push_back(std::move(val));
+    else
+      top[this->member_key] = std::move(val);
+
+    return true;
+  }
+
+  bool bulk_error()
+  {
+    Logger::log()->error("read_preset: unexpected nested data in float array {}, "
+                         "attribute key: {}",
+                         this->member_key,
+                         this->attr_key);
+    return false;
+  }
+
+  bool start_attribute()
+  {
+    auto it = this->attr_map.find(this->attr_key);
+
+    if (it == this->attr_map.end() || !it->second)
+    {
+      Logger::log()->warn("read_preset: unknown attribute key {}, skipped",
+                          this->attr_key);
+      this->skip_depth = 1;
+      return true;
+    }
+
+    this->p_attr = it->second.get();
+    this->head = nlohmann::json::object();
+    this->bulk.clear();
+
+    std::vector<std::string> keys = this->p_attr->json_bulk_keys();
+    this->bulk_keys = std::set<std::string>(keys.begin(), keys.end());
+
+    this->stack = {&this->head};
+    return true;
+  }
+
+  bool start_container(nlohmann::json &&container)
+  {
+    this->is_bulk_member = false;
+
+    if (this->skip_depth > 0 || this->stack.empty())
+    {
+      // within an ignored attribute or non-object value at the root level
+      this->skip_depth++;
+      return true;
+    }
+
+    nlohmann::json &top = *this->stack.back();
+    nlohmann::json *p_child;
+
+    if (top.is_array())
+    {
+      top.push_back(std::move(container));
+      p_child = &top.back();
+    }
+    else
+    {
+      top[this->member_key] = std::move(container);
+      p_child = &top[this->member_key];
+    }
+
+    this->stack.push_back(p_child);
+    return true;
+  }
+
+  void end_attribute()
+  {
+    // do some checking before deserializing the data
+    if (this->head.value("type_string", "") == this->p_attr->get_type_string())
+    {
+      this->p_attr->json_from_bulk(this->head, this->bulk);
+
+      if (this->post_load_fct)
+        this->post_load_fct(this->attr_key);
+    }
+    else
+      Logger::log()->error("read_preset: type mismatch for attribute key {}",
+                           this->attr_key);
+
+    this->p_attr = nullptr;
+    this->head = nlohmann::json();
+    this->bulk.clear();
+    this->bulk_keys.clear();
+  }
+};
+
+
+bool load_preset(
+    const std::string                                         &fname,
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+    std::function<void(const std::string &)>                   post_load_fct)
+{
+  ATTR_TRACE_SCOPE("load_preset");
+
+  std::ifstream file(fname, std::ios::binary);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("Could not open file {} to load JSON", fname);
+    return false;
+  }
+
+  std::set<std::string> loaded_keys;
+
+  bool ret = read_preset(file,
+                         attr_map,
+                         [&loaded_keys, &post_load_fct](const std::string &key)
+                         {
+                           loaded_keys.insert(key);
+                           if (post_load_fct)
+                             post_load_fct(key);
+                         });
+
+  for (auto &[key, _] : attr_map)
+    if (!loaded_keys.contains(key))
+      Logger::log()->error("Could not load preset for parameter: {}", key);
+
+  if (ret)
+    Logger::log()->trace("JSON successfully loaded from {}", fname);
+
+  return ret;
+}
+
+bool read_preset(
+    std::istream                                              &is,
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+    std::function<void(const std::string &)>                   post_load_fct)
+{
+  PresetSaxHandler handler(attr_map, post_load_fct);
+
+  return nlohmann::json::sax_parse(is, &handler);
+}
+
+void write_preset(
+    std::ostream                                                    &os,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map)
+{
+  os << '{';
+
+  bool first = true;
+  for (auto &[key, pa] : attr_map)
+  {
+    if (!pa)
+      continue;
+
+    // one attribute per line, keeps the file readable without pretty-printing
+    os << (first ? "\n" : ",\n");
+    os << nlohmann::json(key).dump() << ':';
+    pa->json_write(os);
+    first = false;
+  }
+
+  os << "\n}\n";
+}
+
+bool save_preset(
+    const std::string                                               &fname,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map)
+{
+  ATTR_TRACE_SCOPE("save_preset");
+
+  std::ofstream file(fname, std::ios::binary);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("Could not open file {} to save JSON", fname);
+    return false;
+  }
+
+  write_preset(file, attr_map);
+  file.close();
+
+  if (file.fail())
+  {
+    Logger::log()->error("Could not write preset to file {}", fname);
+    return false;
+  }
+
+  Logger::log()->trace("JSON successfully saved to {}", fname);
+  return true;
+}
+
+} // namespace attr
@@ -0,0 +1,249 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include "attributes/logger.hpp"
+#include "attributes/preset_io.hpp"
+#include "attributes/preset_journal.hpp"
+
+namespace attr
+{
+
+// helpers
+
+// Write the attributes 'keys' as a single line record, returns the number of bytes
+// written.
+static size_t journal_write_record(
+    std::ostream                                                    &os,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+    const std::vector<std::string>                                  &keys)
+{
+  std::streampos start = os.tellp();
+
+  os << '{';
+
+  bool first = true;
+  for (auto &key : keys)
+  {
+    os << (first ? "" : ",") << nlohmann::json(key).dump() << ':';
+    attr_map.at(key)->json_write(os);
+    first = false;
+  }
+
+  os << "}\n";
+
+  return static_cast<size_t>(os.tellp() - start);
+}
+
+// class definition
+
+PresetJournal::PresetJournal(const std::string &fname, size_t max_records)
+    : fname(fname), max_records(max_records)
+{
+}
+
+bool PresetJournal::compact(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map)
+{
+  Logger::log()->trace("PresetJournal::compact: {}", this->fname);
+
+  std::vector<std::string> keys;
+  for (auto &[key, pa] : attr_map)
+    if (pa)
+      keys.push_back(key);
+
+  std::string   tmp_fname = this->fname + ".tmp";
+  std::ofstream file(tmp_fname, std::ios::binary | std::ios::trunc);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("Could not open file {} to compact journal", tmp_fname);
+    return false;
+  }
+
+  size_t size = journal_write_record(file, attr_map, keys);
+  file.close();
+
+  if (file.fail())
+  {
+    Logger::log()->error("Could not write journal to file {}", tmp_fname);
+    return false;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_fname, this->fname, ec);
+
+  if (ec)
+  {
+    Logger::log()->error("Could not replace journal {}: {}", this->fname, ec.message());
+    return false;
+  }
+
+  // keys no longer in the map are dropped
+  this->saved_states.clear();
+  for (auto &key : keys)
+    this->mark_saved(key, attr_map.at(key).get());
+
+  this->record_count = 1;
+  this->needs_compaction = false;
+  this->journal_size = size;
+  this->snapshot_size = size;
+
+  return true;
+}
+
+std::vector<std::string> PresetJournal::get_dirty_keys(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map) const
+{
+  std::vector<std::string> keys;
+
+  for (auto &[key, pa] : attr_map)
+    if (pa && this->is_dirty(key, pa.get()))
+      keys.push_back(key);
+
+  return keys;
+}
+
+std::string PresetJournal::get_fname() const { return this->fname; }
+
+size_t PresetJournal::get_record_count() const { return this->record_count; }
+
+bool PresetJournal::is_dirty(const std::string       &key,
+                             const AbstractAttribute *p_attr) const
+{
+  auto it = this->saved_states.find(key);
+
+  // the attribute instance may have been replaced, the version counter is then
+  // meaningless
+  if (it == this->saved_states.end() || it->second.p_attr != p_attr)
+    return true;
+
+  // the value digests (get_hash) do not cover the rest of the state (label, bounds...),
+  // any modification since the last save is written
+  return it->second.version != p_attr->get_version();
+}
+
+bool PresetJournal::load(
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map,
+    std::function<void(const std::string &)>                   post_load_fct)
+{
+  Logger::log()->trace("PresetJournal::load: {}", this->fname);
+
+  std::ifstream file(this->fname, std::ios::binary);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("Could not open file {} to load journal", this->fname);
+    return false;
+  }
+
+  std::set<std::string> loaded_keys;
+
+  auto record_post_load_fct = [&loaded_keys, &post_load_fct](const std::string &key)
+  {
+    loaded_keys.insert(key);
+    if (post_load_fct)
+      post_load_fct(key);
+  };
+
+  this->record_count = 0;
+  this->journal_size = 0;
+  this->snapshot_size = 0;
+  this->needs_compaction = false;
+
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty())
+      continue;
+
+    std::istringstream is(line);
+
+    if (!read_preset(is, attr_map, record_post_load_fct))
+    {
+      // only the last record can be truncated, by an interrupted append
+      Logger::log()->warn("PresetJournal::load: invalid record {} in {}, skipped",
+                          this->record_count,
+                          this->fname);
+      this->needs_compaction = true;
+      break;
+    }
+
+    // appending after a record without its end of line would corrupt the next one
+    if (file.eof())
+      this->needs_compaction = true;
+
+    if (this->record_count == 0)
+      this->snapshot_size = line.size() + 1;
+
+    this->record_count++;
+    this->journal_size += line.size() + 1;
+  }
+
+  for (auto &key : loaded_keys)
+    this->mark_saved(key, attr_map.at(key).get());
+
+  for (auto &[key, _] : attr_map)
+    if (!loaded_keys.contains(key))
+      Logger::log()->error("Could not load journal for parameter: {}", key);
+
+  return true;
+}
+
+void PresetJournal::mark_saved(const std::string &key, const AbstractAttribute *p_attr)
+{
+  this->saved_states[key] = SavedState{p_attr, p_attr->get_version()};
+}
+
+bool PresetJournal::save(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map)
+{
+  if (this->record_count == 0 || this->needs_compaction)
+    return this->compact(attr_map);
+
+  std::vector<std::string> keys = this->get_dirty_keys(attr_map);
+
+  if (keys.empty())
+    return true;
+
+  // once the appended records outweigh a full rewrite, replaying the journal costs more
+  // than compacting it
+  if (this->record_count >= this->max_records ||
+      this->journal_size - this->snapshot_size > this->snapshot_size)
+    return this->compact(attr_map);
+
+  Logger::log()->trace("PresetJournal::save: {} attribute(s) to {}",
+                       keys.size(),
+                       this->fname);
+
+  std::ofstream file(this->fname, std::ios::binary | std::ios::app | std::ios::ate);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("Could not open file {} to append journal", this->fname);
+    return false;
+  }
+
+  size_t size = journal_write_record(file, attr_map, keys);
+  file.close();
+
+  if (file.fail())
+  {
+    Logger::log()->error("Could not append journal to file {}", this->fname);
+    return false;
+  }
+
+  for (auto &key : keys)
+    this->mark_saved(key, attr_map.at(key).get());
+
+  this->record_count++;
+  this->journal_size += size;
+
+  return true;
+}
+
+} // namespace attr
@@ -0,0 +1,577 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "attributes/array_attribute.hpp"
+#include "attributes/preset_patch.hpp"
+
+namespace attr
+{
+
+// helpers
+
+static const char     patch_magic[8] = {'A', 'T', 'T', 'R', 'P', 'T', 'C', 'H'};
+static const uint32_t patch_byte_order_mark = 0x01020304;
+
+// bitwise comparison, NaNs included
+static bool same_value(float a, float b)
+{
+  return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static PatchBlock make_block(const std::string        &name,
+                             const std::vector<float> &vec,
+                             uint64_t                  start,
+                             uint64_t                  nrows,
+                             uint64_t                  ncols,
+                             uint64_t                  stride)
+{
+  PatchBlock b = {name, start, nrows, ncols, stride, {}};
+  b.values.reserve(nrows * ncols);
+
+  for (uint64_t r = 0; r < nrows; r++)
+    b.values.insert(b.values.end(),
+                    vec.begin() + start + r * stride,
+                    vec.begin() + start + r * stride + ncols);
+
+  return b;
+}
+
+// Runs of changed values of two arrays of the same size.
+static void diff_runs(const std::string        &name,
+                      const std::vector<float> &va,
+                      const std::vector<float> &vb,
+                      std::vector<PatchBlock>  &blocks)
+{
+  const size_t n = vb.size();
+  size_t       k = 0;
+
+  while (k < n)
+  {
+    if (same_value(va[k], vb[k]))
+    {
+      k++;
+      continue;
+    }
+
+    // extend the run while the next change is close enough
+    size_t start = k;
+    size_t end = k + 1;
+
+    for (size_t j = end; j < n && j < end + ATTR_PATCH_RUN_GAP; j++)
+      if (!same_value(va[j], vb[j]))
+        end = j + 1;
+
+    blocks.push_back(make_block(name, vb, start, 1, end - start, 0));
+    k = end;
+  }
+}
+
+// Changed tiles of two arrays of the same shape, 'nrows' rows of 'ncols' values.
+static void diff_tiles(const std::string        &name,
+                       const std::vector<float> &va,
+                       const std::vector<float> &vb,
+                       size_t                    nrows,
+                       size_t                    ncols,
+                       std::vector<PatchBlock>  &blocks)
+{
+  const size_t ts = ATTR_PATCH_TILE_SIZE;
+
+  for (size_t r0 = 0; r0 < nrows; r0 += ts)
+    for (size_t c0 = 0; c0 < ncols; c0 += ts)
+    {
+      size_t nr = std::min(ts, nrows - r0);
+      size_t nc = std::min(ts, ncols - c0);
+      bool   is_changed = false;
+
+      for (size_t r = 0; r < nr && !is_changed; r++)
+      {
+        size_t k = (r0 + r) * ncols + c0;
+        is_changed = std::memcmp(&va[k], &vb[k], nc * sizeof(float)) != 0;
+      }
+
+      if (is_changed)
+        blocks.push_back(make_block(name, vb, r0 * ncols + c0, nr, nc, ncols));
+    }
+}
+
+// Changed JSON members, arrays of unchanged size are compared element by element
+// unless most of their elements changed. Returns false if a member of 'head_a' is
+// missing in 'head_b' (e.g. the keyframes of a track which was cleared): a delta cannot
+// remove it, the attribute has to be stored whole.
+static bool diff_members(const nlohmann::json &head_a,
+                         const nlohmann::json &head_b,
+                         PatchEntry           &entry)
+{
+  for (auto &[name, va] : head_a.items())
+    if (!head_b.contains(name))
+      return false;
+
+  for (auto &[name, vb] : head_b.items())
+  {
+    if (head_a.contains(name) && head_a[name] == vb)
+      continue;
+
+    if (head_a.contains(name) && head_a[name].is_array() && vb.is_array() &&
+        head_a[name].size() == vb.size())
+    {
+      const nlohmann::json &va = head_a[name];
+      nlohmann::json        changes = nlohmann::json::array();
+
+      for (size_t k = 0; k < vb.size(); k++)
+        if (va[k] != vb[k])
+          changes.push_back({k, vb[k]});
+
+      if (2 * changes.size() < vb.size())
+      {
+        entry.elements[name] = std::move(changes);
+        continue;
+      }
+    }
+
+    entry.members[name] = vb;
+  }
+
+  return true;
+}
+
+static PatchEntry full_entry(const AbstractAttribute &attr)
+{
+  PatchEntry e;
+  BulkArrays bulk;
+
+  e.type = attr.get_type();
+  e.is_full = true;
+  e.members = attr.json_to_bulk(bulk);
+
+  for (auto &[name, vec] : bulk)
+  {
+    PatchBlock b = {name, 0, 1, vec.size(), 0, {}};
+    b.values = std::move(vec);
+    e.blocks.push_back(std::move(b));
+  }
+
+  return e;
+}
+
+// end of the span written by a non-empty block, 'false' if the rows overlap or if the
+// span does not fit in 64 bits (corrupted data)
+static bool block_end(const PatchBlock &b, uint64_t &end)
+{
+  const uint64_t max = std::numeric_limits<uint64_t>::max();
+
+  if (b.nrows > 1 && b.stride < b.ncols)
+    return false;
+
+  if (b.ncols > max - b.start)
+    return false;
+
+  end = b.start + b.ncols;
+
+  if (b.nrows > 1)
+  {
+    if (b.stride > (max - end) / (b.nrows - 1))
+      return false;
+
+    end += (b.nrows - 1) * b.stride;
+  }
+
+  return true;
+}
+
+static bool apply_block(const PatchBlock &b, std::vector<float> &vec)
+{
+  if (b.nrows == 0 || b.ncols == 0)
+    return true;
+
+  uint64_t end = 0;
+
+  if (b.values.size() / b.ncols != b.nrows || b.values.size() % b.ncols != 0 ||
+      !block_end(b, end) || end > vec.size())
+  {
+    Logger::log()->error("PresetPatch::apply: block of member {} out of range", b.name);
+    return false;
+  }
+
+  for (uint64_t r = 0; r < b.nrows; r++)
+    std::copy(b.values.begin() + r * b.ncols,
+              b.values.begin() + (r + 1) * b.ncols,
+              vec.begin() + b.start + r * b.stride);
+
+  return true;
+}
+
+// binary serialization
+
+static void write_bytes(std::vector<char> &out, const void *p, size_t n)
+{
+  const char *c = static_cast<const char *>(p);
+  out.insert(out.end(), c, c + n);
+}
+
+template <typename T> static void write_value(std::vector<char> &out, T v)
+{
+  write_bytes(out, &v, sizeof(T));
+}
+
+static void write_string(std::vector<char> &out, const std::string &str)
+{
+  write_value<uint32_t>(out, (uint32_t)str.size());
+  write_bytes(out, str.data(), str.size());
+}
+
+// bounds-checked reader, every read fails once the data are exhausted
+struct PatchReader
+{
+  const char *data;
+  size_t      size;
+  size_t      pos = 0;
+
+  bool read_bytes(void *p, size_t n)
+  {
+    if (n > this->size - this->pos)
+      return false;
+
+    if (n == 0)
+      return true;
+
+    std::memcpy(p, this->data + this->pos, n);
+    this->pos += n;
+    return true;
+  }
+
+  template <typename T> bool read_value(T &v) { return this->read_bytes(&v, sizeof(T)); }
+
+  bool read_string(std::string &str)
+  {
+    uint32_t n = 0;
+    if (!this->read_value(n) || n > this->size - this->pos)
+      return false;
+
+    str.assign(this->data + this->pos, n);
+    this->pos += n;
+    return true;
+  }
+};
+
+// class definition
+
+bool PresetPatch::apply(
+    std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map) const
+{
+  bool ret = true;
+
+  for (auto &[key, e] : this->entries)
+  {
+    auto it = attr_map.find(key);
+
+    if (it == attr_map.end() || !it->second || it->second->get_type() != e.type)
+    {
+      Logger::log()->error("PresetPatch::apply: attribute {} not found or of a different "
+                           "type",
+                           key);
+      ret = false;
+      continue;
+    }
+
+    AbstractAttribute *p_attr = it->second.get();
+
+    // full state
+    if (e.is_full)
+    {
+      BulkArrays bulk;
+      for (auto &b : e.blocks)
+        bulk[b.name] = b.values;
+
+      p_attr->json_from_bulk(e.members, bulk);
+      continue;
+    }
+
+    // array tiles only, written in place
+    if (e.type == AttributeType::HMAP_ARRAY && e.members.empty() && e.elements.empty())
+    {
+      auto scope = p_attr->get_ref<ArrayAttribute>()->edit_value();
+
+      for (auto &b : e.blocks)
+        ret &= b.name == "vector" && apply_block(b, scope->vector);
+
+      continue;
+    }
+
+    // generic delta, applied to the serialized state
+    BulkArrays     bulk;
+    nlohmann::json json = p_attr->json_to_bulk(bulk);
+    bool           is_valid = true;
+
+    json.update(e.members);
+
+    for (auto &[name, changes] : e.elements.items())
+    {
+      nlohmann::json &array = json[name];
+
+      for (auto &c : changes)
+      {
+        bool   is_index = c.is_array() && c.size() == 2 && c[0].is_number_unsigned();
+        size_t k = is_index ? c[0].get<size_t>() : 0;
+
+        if (!is_index || !array.is_array() || k >= array.size())
+        {
+          Logger::log()->error("PresetPatch::apply: element {} of member {} of "
+                               "attribute {} out of range",
+                               k,
+                               name,
+                               key);
+          is_valid = false;
+          break;
+        }
+
+        array[k] = c[1];
+      }
+    }
+
+    for (auto &b : e.blocks)
+      is_valid &= bulk.contains(b.name) && apply_block(b, bulk[b.name]);
+
+    if (!is_valid)
+    {
+      ret = false;
+      continue;
+    }
+
+    p_attr->json_from_bulk(json, bulk);
+  }
+
+  return ret;
+}
+
+bool PresetPatch::deserialize(const char *data, size_t size)
+{
+  this->entries.clear();
+
+  PatchReader reader = {data, size};
+  char        magic[8];
+  uint32_t    version = 0;
+  uint32_t    byte_order_mark = 0;
+  uint64_t    count = 0;
+
+  if (!reader.read_bytes(magic, sizeof(magic)) || !reader.read_value(version) ||
+      !reader.read_value(byte_order_mark) || !reader.read_value(count) ||
+      std::memcmp(magic, patch_magic, sizeof(magic)) != 0 ||
+      version != ATTR_PATCH_VERSION || byte_order_mark != patch_byte_order_mark)
+  {
+    Logger::log()->error("PresetPatch::deserialize: invalid header");
+    return false;
+  }
+
+  for (uint64_t i = 0; i < count; i++)
+  {
+    std::string key;
+    std::string head;
+    PatchEntry  e;
+    uint32_t    type = 0;
+    uint32_t    is_full = 0;
+    uint32_t    nblocks = 0;
+
+    bool is_valid = reader.read_string(key) && reader.read_value(type) &&
+                    reader.read_value(is_full) && reader.read_string(head) &&
+                    reader.read_value(nblocks);
+
+    if (is_valid)
+    {
+      nlohmann::json j = nlohmann::json::from_cbor(head, true, false);
+      is_valid = j.is_object() && j.contains("m") && j.contains("e") &&
+                 type < static_cast<uint32_t>(AttributeType::INVALID);
+
+      if (is_valid)
+      {
+        e.type = static_cast<AttributeType>(type);
+        e.is_full = is_full != 0;
+        e.members = std::move(j["m"]);
+        e.elements = std::move(j["e"]);
+      }
+    }
+
+    for (uint32_t k = 0; k < nblocks && is_valid; k++)
+    {
+      PatchBlock b;
+
+      is_valid = reader.read_string(b.name) && reader.read_value(b.start) &&
+                 reader.read_value(b.nrows) && reader.read_value(b.ncols) &&
+                 reader.read_value(b.stride);
+
+      // guard the allocation against corrupted sizes
+      uint64_t n = b.nrows * b.ncols;
+      uint64_t end = 0;
+      is_valid = is_valid && (b.ncols == 0 || n / b.ncols == b.nrows) &&
+                 n <= (size - reader.pos) / sizeof(float) &&
+                 (n == 0 || block_end(b, end));
+
+      if (is_valid)
+      {
+        b.values.resize(n);
+        is_valid = reader.read_bytes(b.values.data(), n * sizeof(float));
+        e.blocks.push_back(std::move(b));
+      }
+    }
+
+    if (!is_valid)
+    {
+      Logger::log()->error("PresetPatch::deserialize: corrupted data");
+      this->entries.clear();
+      return false;
+    }
+
+    this->entries[key] = std::move(e);
+  }
+
+  return true;
+}
+
+bool PresetPatch::empty() const { return this->entries.empty(); }
+
+const std::map<std::string, PatchEntry> &PresetPatch::get_entries() const
+{
+  return this->entries;
+}
+
+std::vector<std::string> PresetPatch::get_keys() const
+{
+  std::vector<std::string> keys;
+  for (auto &[key, _] : this->entries)
+    keys.push_back(key);
+  return keys;
+}
+
+std::vector<char> PresetPatch::serialize() const
+{
+  std::vector<char> out;
+
+  write_bytes(out, patch_magic, sizeof(patch_magic));
+  write_value<uint32_t>(out, ATTR_PATCH_VERSION);
+  write_value<uint32_t>(out, patch_byte_order_mark);
+  write_value<uint64_t>(out, this->entries.size());
+
+  for (auto &[key, e] : this->entries)
+  {
+    std::vector<uint8_t> head = nlohmann::json::to_cbor(
+        nlohmann::json({{"m", e.members}, {"e", e.elements}}));
+
+    write_string(out, key);
+    write_value<uint32_t>(out, (uint32_t)e.type);
+    write_value<uint32_t>(out, e.is_full ? 1 : 0);
+    write_string(out, std::string(head.begin(), head.end()));
+    write_value<uint32_t>(out, (uint32_t)e.blocks.size());
+
+    for (auto &b : e.blocks)
+    {
+      write_string(out, b.name);
+      write_value<uint64_t>(out, b.start);
+      write_value<uint64_t>(out, b.nrows);
+      write_value<uint64_t>(out, b.ncols);
+      write_value<uint64_t>(out, b.stride);
+      write_bytes(out, b.values.data(), b.values.size() * sizeof(float));
+    }
+  }
+
+  return out;
+}
+
+void PresetPatch::set_entry(const std::string &key, PatchEntry &&entry)
+{
+  this->entries[key] = std::move(entry);
+}
+
+size_t PresetPatch::size() const { return this->entries.size(); }
+
+// functions
+
+PresetPatch diff_attributes(
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map_a,
+    const std::map<std::string, std::unique_ptr<AbstractAttribute>> &attr_map_b)
+{
+  PresetPatch patch;
+
+  for (auto &[key, pb] : attr_map_b)
+  {
+    if (!pb)
+      continue;
+
+    auto                     it = attr_map_a.find(key);
+    const AbstractAttribute *pa = it == attr_map_a.end() ? nullptr : it->second.get();
+
+    if (!pa || pa->get_type() != pb->get_type())
+    {
+      patch.set_entry(key, full_entry(*pb));
+      continue;
+    }
+
+    // the value digests are memoized on the attribute versions, they spare the
+    // comparison of unchanged values. They do not cover the rest of the state (label,
+    // bounds, choice list...), the JSON heads are always compared
+    bool is_same_value = pa->get_hash() == pb->get_hash();
+
+    PatchEntry e;
+    e.type = pb->get_type();
+
+    if (e.type == AttributeType::HMAP_ARRAY)
+    {
+      // the arrays are read in place, shape changes are stored whole
+      auto              *p_array_a = static_cast<const ArrayAttribute *>(pa);
+      auto              *p_array_b = static_cast<const ArrayAttribute *>(pb.get());
+      const hmap::Array &va = p_array_a->get_value_cref();
+      const hmap::Array &vb = p_array_b->get_value_cref();
+
+      if (va.shape != vb.shape)
+      {
+        patch.set_entry(key, full_entry(*pb));
+        continue;
+      }
+
+      if (!diff_members(pa->AbstractAttribute::json_to(),
+                        pb->AbstractAttribute::json_to(),
+                        e))
+      {
+        patch.set_entry(key, full_entry(*pb));
+        continue;
+      }
+
+      if (!is_same_value)
+        diff_tiles("vector", va.vector, vb.vector, vb.shape.x, vb.shape.y, e.blocks);
+    }
+    else
+    {
+      BulkArrays     bulk_a, bulk_b;
+      nlohmann::json head_a = pa->json_to_bulk(bulk_a);
+      nlohmann::json head_b = pb->json_to_bulk(bulk_b);
+
+      if (!diff_members(head_a, head_b, e))
+      {
+        patch.set_entry(key, full_entry(*pb));
+        continue;
+      }
+
+      for (auto &[name, vb] : bulk_b)
+      {
+        if (is_same_value)
+          break;
+
+        std::vector<float> &va = bulk_a[name];
+
+        if (va.size() == vb.size())
+          diff_runs(name, va, vb, e.blocks);
+        else
+          e.blocks.push_back(make_block(name, vb, 0, 1, vb.size(), 0));
+      }
+    }
+
+    if (!e.members.empty() || !e.elements.empty() || !e.blocks.empty())
+      patch.set_entry(key, std::move(e));
+  }
+
+  return patch;
+}
+
+} // namespace attr
@@ -2,6 +2,9 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #include "attributes/range_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -35,52 +38,142 @@ RangeAttribute::RangeAttribute(const std::string &label,
   this->save_initial_state();
 }
 
+void RangeAttribute::blend_value(const AbstractAttribute &a,
+                                 const AbstractAttribute &b,
+                                 float                    t)
+{
+  glm::vec2 va = static_cast<const RangeAttribute &>(a).value;
+  glm::vec2 vb = static_cast<const RangeAttribute &>(b).value;
+  this->set_value(glm::mix(va, vb, t));
+}
+
 bool RangeAttribute::get_autorange() const { return this->autorange; }
 
-std::function<PairVec()> RangeAttribute::get_histogram_fct() const
+HistogramFct RangeAttribute::get_histogram_fct() const
 {
   return this->histogram_fct;
 }
 
+std::function<uint64_t()> RangeAttribute::get_histogram_version_fct() const
+{
+  return this->histogram_version_fct;
+}
+
 bool RangeAttribute::get_is_active() const { return this->is_active; }
 
 glm::vec2 RangeAttribute::get_value() const { return this->value; }
 
-std::string RangeAttribute::get_value_format() const { return this->value_format; }
+SharedString RangeAttribute::get_value_format() const
+{
+  return this->value_format.get_pattern();
+}
 
 float RangeAttribute::get_vmin() const { return this->vmin; }
 
 float RangeAttribute::get_vmax() const { return this->vmax; }
 
+ValueWriteScope<KeyframeTrack> RangeAttribute::edit_track()
+{
+  return ValueWriteScope<KeyframeTrack>(this, &this->track);
+}
+
+const KeyframeTrack &RangeAttribute::get_track() const { return this->track; }
+
+glm::vec2 RangeAttribute::get_value_at(float time) const
+{
+  glm::vec2 out;
+  this->track.evaluate(time, &out.x, &this->value.x);
+  return out;
+}
+
+void RangeAttribute::get_values_at(std::span<const float> times, float *out) const
+{
+  this->track.evaluate(times, out, &this->value.x);
+}
+
 void RangeAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get(json, "value", value);
-  json_safe_get(json, "vmin", vmin);
-  json_safe_get(json, "vmax", vmax);
-  json_safe_get(json, "is_active", is_active);
+  ATTR_TRACE_SCOPE("RangeAttribute::json_from");
+
+  using Schema = JsonSchema<RangeAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&RangeAttribute::value>("value"),
+      Schema::member<&RangeAttribute::vmin>("vmin"),
+      Schema::member<&RangeAttribute::vmax>("vmax"),
+      Schema::member<&RangeAttribute::is_active>("is_active"),
+      {"keyframes",
+       [](RangeAttribute &a, const nlohmann::json &j) { a.track.json_from(j); },
+       false}};
+
+  this->bump_version();
+  this->track.clear();
+  schema.read(json, *this);
 }
 
 nlohmann::json RangeAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("RangeAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = {this->value.x, this->value.y};
   json["vmin"] = this->vmin;
   json["vmax"] = this->vmax;
   json["is_active"] = this->is_active;
+
+  if (!this->track.empty())
+    json["keyframes"] = this->track.json_to();
+
   return json;
 }
 
+uint64_t RangeAttribute::hash() const
+{
+  uint64_t h = hash_combine(hash_value(this->value), hash_value(this->is_active));
+  return this->track.empty() ? h : hash_combine(h, this->track.hash());
+}
+
+MemoryUsage RangeAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  usage.value += this->track.memory_usage();
+  return usage;
+}
+
 void RangeAttribute::set_autorange(bool new_state) { this->autorange = new_state; }
 
-void RangeAttribute::set_histogram_fct(std::function<PairVec()> new_histogram_fct)
+void RangeAttribute::set_histogram_fct(HistogramFct new_histogram_fct)
 {
   this->histogram_fct = new_histogram_fct;
 }
 
-void RangeAttribute::set_is_active(bool new_state) { this->is_active = new_state; }
+void RangeAttribute::set_histogram_fct(std::function<PairVec()> new_histogram_fct)
+{
+  if (new_histogram_fct)
+    this->histogram_fct = [new_histogram_fct](const std::atomic<bool> &)
+    { return new_histogram_fct(); };
+  else
+    this->histogram_fct = nullptr;
+}
 
-void RangeAttribute::set_value(const glm::vec2 &new_value) { this->value = new_value; }
+void RangeAttribute::set_histogram_version_fct(
+    std::function<uint64_t()> new_histogram_version_fct)
+{
+  this->histogram_version_fct = new_histogram_version_fct;
+}
+
+void RangeAttribute::set_is_active(bool new_state)
+{
+  this->is_active = new_state;
+  this->bump_version();
+}
+
+void RangeAttribute::set_value(const glm::vec2 &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 std::string RangeAttribute::to_string()
 {
@@ -2,6 +2,9 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #include "attributes/resolution_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -37,20 +40,32 @@ std::pair<int, int> ResolutionAttribute::get_value() const
   return {this->width, this->height};
 }
 
-std::string ResolutionAttribute::get_value_format() const { return this->value_format; }
+SharedString ResolutionAttribute::get_value_format() const
+{
+  return this->value_format.get_pattern();
+}
 
 void ResolutionAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get(json, "width", width);
-  json_safe_get(json, "height", height);
-  json_safe_get(json, "keep_aspect_ratio", keep_aspect_ratio);
-  json_safe_get(json, "power_of_two", power_of_two);
+  ATTR_TRACE_SCOPE("ResolutionAttribute::json_from");
+
+  using Schema = JsonSchema<ResolutionAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&ResolutionAttribute::width>("width"),
+      Schema::member<&ResolutionAttribute::height>("height"),
+      Schema::member<&ResolutionAttribute::keep_aspect_ratio>("keep_aspect_ratio"),
+      Schema::member<&ResolutionAttribute::power_of_two>("power_of_two")};
+
+  this->bump_version();
+  schema.read(json, *this);
   this->update_aspect_ratio();
 }
 
 nlohmann::json ResolutionAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("ResolutionAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["width"] = this->width;
   json["height"] = this->height;
@@ -59,6 +74,18 @@ nlohmann::json ResolutionAttribute::json_to() const
   return json;
 }
 
+uint64_t ResolutionAttribute::hash() const
+{
+  return hash_combine(hash_value(this->width), hash_value(this->height));
+}
+
+MemoryUsage ResolutionAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  return usage;
+}
+
 int ResolutionAttribute::make_power_of_two(int value, bool return_upper) const
 {
   if (value <= 0)
@@ -83,6 +110,7 @@ void ResolutionAttribute::set_height(int h)
 
   this->height = std::max(1, h);
   this->update_aspect_ratio();
+  this->bump_version();
 }
 
 void ResolutionAttribute::set_keep_aspect_ratio(bool enabled)
@@ -90,6 +118,8 @@ void ResolutionAttribute::set_keep_aspect_ratio(bool enabled)
   this->keep_aspect_ratio = enabled;
   if (enabled)
     this->update_aspect_ratio();
+
+  this->bump_version();
 }
 
 void ResolutionAttribute::set_power_of_two(bool enabled)
@@ -100,12 +130,15 @@ void ResolutionAttribute::set_power_of_two(bool enabled)
     this->width = make_power_of_two(this->width);
     this->height = make_power_of_two(this->height);
   }
+
+  this->bump_version();
 }
 
 void ResolutionAttribute::set_value(int w, int h)
 {
   this->width = w;
   this->height = h;
+  this->bump_version();
 }
 
 void ResolutionAttribute::set_width(int w)
@@ -118,6 +151,7 @@ void ResolutionAttribute::set_width(int w)
 
   this->width = std::max(1, w);
   this->update_aspect_ratio();
+  this->bump_version();
 }
 
 std::string ResolutionAttribute::to_string()
@@ -3,6 +3,9 @@
  * this software. */
 
 #include "attributes/seed_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -24,18 +27,42 @@ uint SeedAttribute::get_value() const { return this->value; }
 
 void SeedAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  this->value = json["value"].get<uint>();
+  ATTR_TRACE_SCOPE("SeedAttribute::json_from");
+
+  using Schema = JsonSchema<SeedAttribute>;
+
+  static const Schema schema = {Schema::member<&SeedAttribute::value>("value")};
+
+  this->bump_version();
+  schema.read(json, *this);
 }
 
 nlohmann::json SeedAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("SeedAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
-  json["value"] = this->value;
+  json["value"] = this->value.load();
   return json;
 }
 
-void SeedAttribute::set_value(const uint &new_value) { this->value = new_value; }
+uint64_t SeedAttribute::hash() const
+{
+  return hash_value(this->value.load());
+}
+
+MemoryUsage SeedAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  return usage;
+}
+
+void SeedAttribute::set_value(const uint &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 std::string SeedAttribute::to_string() { return std::to_string(this->value); }
 
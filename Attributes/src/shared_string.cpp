@@ -0,0 +1,70 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
+#include "attributes/shared_string.hpp"
+
+namespace attr
+{
+
+// helpers
+
+// transparent hash, allows lookups with a string_view without building a string
+struct StringPoolHash
+{
+  using is_transparent = void;
+
+  size_t operator()(std::string_view str) const
+  {
+    return std::hash<std::string_view>{}(str);
+  }
+};
+
+// the nodes of an unordered_set are stable, pointers to the strings remain valid
+struct StringPool
+{
+  std::shared_mutex                                                mutex;
+  std::unordered_set<std::string, StringPoolHash, std::equal_to<>> strings;
+};
+
+static StringPool &string_pool()
+{
+  static StringPool pool;
+  return pool;
+}
+
+// class definition
+
+SharedString::SharedString()
+{
+  static const std::string *p_empty = intern_string("");
+  this->p_str = p_empty;
+}
+
+SharedString::SharedString(const char *str) : p_str(intern_string(str)) {}
+
+SharedString::SharedString(const std::string &str) : p_str(intern_string(str)) {}
+
+SharedString::SharedString(std::string_view str) : p_str(intern_string(str)) {}
+
+// functions
+
+const std::string *intern_string(std::string_view str)
+{
+  StringPool &pool = string_pool();
+
+  {
+    std::shared_lock lock(pool.mutex);
+    auto             it = pool.strings.find(str);
+    if (it != pool.strings.end())
+      return &(*it);
+  }
+
+  std::unique_lock lock(pool.mutex);
+  return &(*pool.strings.emplace(str).first);
+}
+
+} // namespace attr
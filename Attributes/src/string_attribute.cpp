@@ -3,6 +3,9 @@
  * this software. */
 
 #include "attributes/string_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -29,25 +32,52 @@ std::string StringAttribute::get_value() const { return this->value; }
 
 void StringAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get<std::string>(json, "value", value);
-  json_safe_get(json, "read_only", read_only);
+  ATTR_TRACE_SCOPE("StringAttribute::json_from");
+
+  using Schema = JsonSchema<StringAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&StringAttribute::value>("value"),
+      Schema::member<&StringAttribute::read_only>("read_only")};
+
+  this->bump_version();
+  schema.read(json, *this);
 }
 
 nlohmann::json StringAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("StringAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = this->value;
   json["read_only"] = this->read_only;
   return json;
 }
 
+uint64_t StringAttribute::hash() const
+{
+  return hash_string(this->value);
+}
+
+MemoryUsage StringAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  usage.value += string_memory_usage(this->value);
+  return usage;
+}
+
 void StringAttribute::set_read_only(bool new_read_only)
 {
   this->read_only = new_read_only;
+  this->bump_version();
 }
 
-void StringAttribute::set_value(const std::string &new_value) { this->value = new_value; }
+void StringAttribute::set_value(const std::string &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 std::string StringAttribute::to_string() { return this->value; }
 
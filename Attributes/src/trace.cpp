@@ -0,0 +1,248 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <fstream>
+
+#include "nlohmann/json.hpp"
+
+#include "attributes/logger.hpp"
+#include "attributes/trace.hpp"
+
+namespace attr
+{
+
+// helpers
+
+static std::string format_duration(double ns)
+{
+  if (ns < 1e3)
+    return std::format("{:.0f} ns", ns);
+  else if (ns < 1e6)
+    return std::format("{:.1f} us", ns * 1e-3);
+  else
+    return std::format("{:.2f} ms", ns * 1e-6);
+}
+
+// class definition
+
+void TraceStats::add(uint64_t duration)
+{
+  this->count++;
+  this->total += duration;
+  this->min = std::min(this->min, duration);
+  this->max = std::max(this->max, duration);
+
+  size_t k = duration ? std::bit_width(duration) - 1 : 0;
+  this->buckets[std::min(k, size_t(ATTR_TRACE_NBUCKETS - 1))]++;
+}
+
+void TraceStats::merge(const TraceStats &other)
+{
+  this->count += other.count;
+  this->total += other.total;
+  this->min = std::min(this->min, other.min);
+  this->max = std::max(this->max, other.max);
+
+  for (size_t k = 0; k < this->buckets.size(); k++)
+    this->buckets[k] += other.buckets[k];
+}
+
+double TraceStats::mean() const
+{
+  return this->count ? static_cast<double>(this->total) / this->count : 0.;
+}
+
+uint64_t TraceStats::percentile(double p) const
+{
+  if (this->count == 0)
+    return 0;
+
+  uint64_t rank = static_cast<uint64_t>(std::clamp(p, 0., 1.) * (this->count - 1)) + 1;
+  uint64_t n = 0;
+
+  for (size_t k = 0; k < this->buckets.size(); k++)
+  {
+    n += this->buckets[k];
+    if (n >= rank)
+      return std::min(this->max, (uint64_t(2) << k) - 1);
+  }
+
+  return this->max;
+}
+
+Tracer::Tracer() : t_origin(Tracer::clock()) {}
+
+Tracer &Tracer::get()
+{
+  static Tracer instance;
+  return instance;
+}
+
+void Tracer::clear()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  for (auto &p_buffer : this->buffers)
+  {
+    std::lock_guard<std::mutex> buffer_lock(p_buffer->mutex);
+    p_buffer->events.clear();
+    p_buffer->stats.clear();
+  }
+}
+
+std::map<std::string, TraceStats> Tracer::get_stats() const
+{
+  std::map<std::string, TraceStats> stats;
+  std::lock_guard<std::mutex>       lock(this->mutex);
+
+  for (auto &p_buffer : this->buffers)
+  {
+    std::lock_guard<std::mutex> buffer_lock(p_buffer->mutex);
+    for (auto &[name, s] : p_buffer->stats)
+      stats[name].merge(s);
+  }
+
+  return stats;
+}
+
+std::string Tracer::get_stats_string() const
+{
+  std::map<std::string, TraceStats> stats = this->get_stats();
+
+  std::vector<const std::pair<const std::string, TraceStats> *> sorted;
+  for (auto &entry : stats)
+    sorted.push_back(&entry);
+
+  std::stable_sort(sorted.begin(),
+                   sorted.end(),
+                   [](const auto *a, const auto *b)
+                   { return a->second.total > b->second.total; });
+
+  std::string str;
+  for (auto *p_entry : sorted)
+  {
+    const TraceStats &s = p_entry->second;
+
+    str += std::format("{}: count {}, total {}, mean {}, min {}, p50 {}, p99 {}, "
+                       "max {}\n",
+                       p_entry->first,
+                       s.count,
+                       format_duration(s.total),
+                       format_duration(s.mean()),
+                       format_duration(s.min),
+                       format_duration(s.percentile(0.5)),
+                       format_duration(s.percentile(0.99)),
+                       format_duration(s.max));
+  }
+
+  return str;
+}
+
+Tracer::ThreadBuffer &Tracer::get_thread_buffer()
+{
+  // the tracer holds a reference, the events survive the thread
+  thread_local std::shared_ptr<ThreadBuffer> p_buffer;
+
+  if (!p_buffer)
+  {
+    p_buffer = std::make_shared<ThreadBuffer>();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    p_buffer->tid = this->buffers.size() + 1;
+    this->buffers.push_back(p_buffer);
+  }
+
+  return *p_buffer;
+}
+
+void Tracer::record_counter(const char *name, double value)
+{
+  if (!this->is_enabled())
+    return;
+
+  ThreadBuffer               &buffer = this->get_thread_buffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+
+  if (buffer.events.size() < ATTR_TRACE_MAX_EVENTS)
+    buffer.events.push_back({name, Tracer::clock(), -1, value});
+}
+
+void Tracer::record_scope(const char *name, int64_t t_start, int64_t t_end)
+{
+  ThreadBuffer               &buffer = this->get_thread_buffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+
+  int64_t duration = std::max(int64_t(0), t_end - t_start);
+
+  if (buffer.events.size() < ATTR_TRACE_MAX_EVENTS)
+    buffer.events.push_back({name, t_start, duration, 0.});
+
+  buffer.stats[name].add(static_cast<uint64_t>(duration));
+}
+
+bool Tracer::save_chrome_trace(const std::string &fname) const
+{
+  std::ofstream f(fname);
+
+  if (!f.is_open())
+  {
+    Logger::log()->error("Tracer::save_chrome_trace: could not open file {}", fname);
+    return false;
+  }
+
+  this->write_chrome_trace(f);
+  return f.good();
+}
+
+void Tracer::set_enabled(bool new_state)
+{
+  this->enabled.store(new_state, std::memory_order_relaxed);
+}
+
+void Tracer::write_chrome_trace(std::ostream &os) const
+{
+  // timestamps in microseconds, relative to the tracer creation
+  auto to_us = [this](int64_t t) { return (t - this->t_origin) * 1e-3; };
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+  bool is_first = true;
+
+  for (auto &p_buffer : this->buffers)
+  {
+    std::lock_guard<std::mutex> buffer_lock(p_buffer->mutex);
+
+    for (auto &e : p_buffer->events)
+    {
+      std::string name = nlohmann::json(e.name).dump();
+
+      os << (is_first ? "\n" : ",\n");
+      is_first = false;
+
+      if (e.duration >= 0)
+        os << std::format("{{\"name\":{},\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+                          "\"pid\":1,\"tid\":{}}}",
+                          name,
+                          to_us(e.t_start),
+                          e.duration * 1e-3,
+                          p_buffer->tid);
+      else
+        os << std::format("{{\"name\":{},\"ph\":\"C\",\"ts\":{:.3f},\"pid\":1,"
+                          "\"tid\":{},\"args\":{{\"value\":{}}}}}",
+                          name,
+                          to_us(e.t_start),
+                          p_buffer->tid,
+                          std::isfinite(e.value) ? e.value : 0.);
+    }
+  }
+
+  os << "\n]}\n";
+}
+
+} // namespace attr
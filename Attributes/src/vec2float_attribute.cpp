@@ -3,6 +3,9 @@
  * this software. */
 
 #include "attributes/vec2float_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -28,14 +31,53 @@ Vec2FloatAttribute::Vec2FloatAttribute(const std::string &label,
   this->save_initial_state();
 }
 
+void Vec2FloatAttribute::blend_value(const AbstractAttribute &a,
+                                     const AbstractAttribute &b,
+                                     float                    t)
+{
+  glm::vec2 va = static_cast<const Vec2FloatAttribute &>(a).value;
+  glm::vec2 vb = static_cast<const Vec2FloatAttribute &>(b).value;
+  this->set_value(glm::mix(va, vb, t));
+}
+
+ValueWriteScope<KeyframeTrack> Vec2FloatAttribute::edit_track()
+{
+  return ValueWriteScope<KeyframeTrack>(this, &this->track);
+}
+
+const KeyframeTrack &Vec2FloatAttribute::get_track() const { return this->track; }
+
+glm::vec2 Vec2FloatAttribute::get_value_at(float time) const
+{
+  glm::vec2 out;
+  this->track.evaluate(time, &out.x, &this->value.x);
+  return out;
+}
+
+void Vec2FloatAttribute::get_values_at(std::span<const float> times, float *out) const
+{
+  this->track.evaluate(times, out, &this->value.x);
+}
+
 void Vec2FloatAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get(json, "value", value);
-  json_safe_get(json, "xmin", xmin);
-  json_safe_get(json, "xmax", xmax);
-  json_safe_get(json, "ymin", ymin);
-  json_safe_get(json, "ymax", ymax);
+  ATTR_TRACE_SCOPE("Vec2FloatAttribute::json_from");
+
+  using Schema = JsonSchema<Vec2FloatAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&Vec2FloatAttribute::value>("value"),
+      Schema::member<&Vec2FloatAttribute::xmin>("xmin"),
+      Schema::member<&Vec2FloatAttribute::xmax>("xmax"),
+      Schema::member<&Vec2FloatAttribute::ymin>("ymin"),
+      Schema::member<&Vec2FloatAttribute::ymax>("ymax"),
+      {"keyframes",
+       [](Vec2FloatAttribute &a, const nlohmann::json &j) { a.track.json_from(j); },
+       false}};
+
+  this->bump_version();
+  this->track.clear();
+  schema.read(json, *this);
 }
 
 glm::vec2 Vec2FloatAttribute::get_value() const { return this->value; }
@@ -50,18 +92,39 @@ float Vec2FloatAttribute::get_ymax() const { return this->ymax; }
 
 nlohmann::json Vec2FloatAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("Vec2FloatAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = {this->value.x, this->value.y};
   json["xmin"] = this->xmin;
   json["xmax"] = this->xmax;
   json["ymin"] = this->ymin;
   json["ymax"] = this->ymax;
+
+  if (!this->track.empty())
+    json["keyframes"] = this->track.json_to();
+
   return json;
 }
 
+uint64_t Vec2FloatAttribute::hash() const
+{
+  uint64_t h = hash_value(this->value);
+  return this->track.empty() ? h : hash_combine(h, this->track.hash());
+}
+
+MemoryUsage Vec2FloatAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  usage.value += this->track.memory_usage();
+  return usage;
+}
+
 void Vec2FloatAttribute::set_value(const glm::vec2 &new_value)
 {
   this->value = new_value;
+  this->bump_version();
 }
 
 std::string Vec2FloatAttribute::to_string()
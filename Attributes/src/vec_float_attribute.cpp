@@ -2,6 +2,9 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #include "attributes/vec_float_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -17,17 +20,60 @@ VecFloatAttribute::VecFloatAttribute(const std::string        &label,
   this->save_initial_state();
 }
 
+void VecFloatAttribute::blend_value(const AbstractAttribute &a,
+                                    const AbstractAttribute &b,
+                                    float                    t)
+{
+  const std::vector<float> &va = static_cast<const VecFloatAttribute &>(a).value;
+  const std::vector<float> &vb = static_cast<const VecFloatAttribute &>(b).value;
+
+  if (va.size() != vb.size())
+  {
+    AbstractAttribute::blend_value(a, b, t);
+    return;
+  }
+
+  // element-wise, 'a' or 'b' may be this attribute
+  this->value.resize(va.size());
+
+  const float *pa = va.data();
+  const float *pb = vb.data();
+  float       *pv = this->value.data();
+
+  for (size_t k = 0; k < this->value.size(); k++)
+    pv[k] = pa[k] + t * (pb[k] - pa[k]);
+
+  this->bump_version();
+}
+
 void VecFloatAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get<std::vector<float>>(json, "value", value);
-  json_safe_get(json, "vmin", vmin);
-  json_safe_get(json, "vmax", vmax);
+  ATTR_TRACE_SCOPE("VecFloatAttribute::json_from");
+
+  using Schema = JsonSchema<VecFloatAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&VecFloatAttribute::value>("value"),
+      Schema::member<&VecFloatAttribute::vmin>("vmin"),
+      Schema::member<&VecFloatAttribute::vmax>("vmax")};
+
+  this->bump_version();
+  schema.read(json, *this);
+}
+
+ValueWriteScope<std::vector<float>> VecFloatAttribute::edit_value()
+{
+  return ValueWriteScope<std::vector<float>>(this, &this->value);
 }
 
 std::vector<float> VecFloatAttribute::get_value() const { return this->value; }
 
-std::vector<float> *VecFloatAttribute::get_value_ref() { return &this->value; }
+std::vector<float> *VecFloatAttribute::get_value_ref()
+{
+  // the caller is given write access, consider the value as modified
+  this->bump_version();
+  return &this->value;
+}
 
 float VecFloatAttribute::get_vmin() const { return this->vmin; }
 
@@ -35,6 +81,8 @@ float VecFloatAttribute::get_vmax() const { return this->vmax; }
 
 nlohmann::json VecFloatAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("VecFloatAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = this->value;
   json["vmin"] = this->vmin;
@@ -42,9 +90,23 @@ nlohmann::json VecFloatAttribute::json_to() const
   return json;
 }
 
+uint64_t VecFloatAttribute::hash() const
+{
+  return hash_vector(this->value);
+}
+
+MemoryUsage VecFloatAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  usage.value += vector_memory_usage(this->value);
+  return usage;
+}
+
 void VecFloatAttribute::set_value(const std::vector<float> &new_value)
 {
   this->value = new_value;
+  this->bump_version();
 }
 
 std::string VecFloatAttribute::to_string()
@@ -3,6 +3,9 @@
  * this software. */
 
 #include "attributes/vec_int_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -18,9 +21,19 @@ VecIntAttribute::VecIntAttribute(const std::string      &label,
   this->save_initial_state();
 }
 
+ValueWriteScope<std::vector<int>> VecIntAttribute::edit_value()
+{
+  return ValueWriteScope<std::vector<int>>(this, &this->value);
+}
+
 std::vector<int> VecIntAttribute::get_value() const { return this->value; }
 
-std::vector<int> *VecIntAttribute::get_value_ref() { return &this->value; }
+std::vector<int> *VecIntAttribute::get_value_ref()
+{
+  // the caller is given write access, consider the value as modified
+  this->bump_version();
+  return &this->value;
+}
 
 int VecIntAttribute::get_vmin() const { return this->vmin; }
 
@@ -28,14 +41,23 @@ int VecIntAttribute::get_vmax() const { return this->vmax; }
 
 void VecIntAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get<std::vector<int>>(json, "value", value);
-  json_safe_get(json, "vmin", vmin);
-  json_safe_get(json, "vmax", vmax);
+  ATTR_TRACE_SCOPE("VecIntAttribute::json_from");
+
+  using Schema = JsonSchema<VecIntAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&VecIntAttribute::value>("value"),
+      Schema::member<&VecIntAttribute::vmin>("vmin"),
+      Schema::member<&VecIntAttribute::vmax>("vmax")};
+
+  this->bump_version();
+  schema.read(json, *this);
 }
 
 nlohmann::json VecIntAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("VecIntAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = this->value;
   json["vmin"] = this->vmin;
@@ -43,9 +65,23 @@ nlohmann::json VecIntAttribute::json_to() const
   return json;
 }
 
+uint64_t VecIntAttribute::hash() const
+{
+  return hash_vector(this->value);
+}
+
+MemoryUsage VecIntAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  usage.value += vector_memory_usage(this->value);
+  return usage;
+}
+
 void VecIntAttribute::set_value(const std::vector<int> &new_value)
 {
   this->value = new_value;
+  this->bump_version();
 }
 
 std::string VecIntAttribute::to_string()
@@ -3,6 +3,9 @@
  * this software. */
 
 #include "attributes/wave_nb_attribute.hpp"
+#include "attributes/hash.hpp"
+#include "attributes/json_schema.hpp"
+#include "attributes/trace.hpp"
 
 namespace attr
 {
@@ -36,38 +39,108 @@ WaveNbAttribute::WaveNbAttribute(const std::string &label,
   this->save_initial_state();
 }
 
+void WaveNbAttribute::blend_value(const AbstractAttribute &a,
+                                  const AbstractAttribute &b,
+                                  float                    t)
+{
+  glm::vec2 va = static_cast<const WaveNbAttribute &>(a).value;
+  glm::vec2 vb = static_cast<const WaveNbAttribute &>(b).value;
+  this->set_value(glm::mix(va, vb, t));
+}
+
 bool WaveNbAttribute::get_link_xy() const { return this->link_xy; }
 
 glm::vec2 WaveNbAttribute::get_value() const { return this->value; }
 
-std::string WaveNbAttribute::get_value_format() const { return this->value_format; }
+SharedString WaveNbAttribute::get_value_format() const
+{
+  return this->value_format.get_pattern();
+}
 
 float WaveNbAttribute::get_vmin() const { return this->vmin; }
 
 float WaveNbAttribute::get_vmax() const { return this->vmax; }
 
+ValueWriteScope<KeyframeTrack> WaveNbAttribute::edit_track()
+{
+  return ValueWriteScope<KeyframeTrack>(this, &this->track);
+}
+
+const KeyframeTrack &WaveNbAttribute::get_track() const { return this->track; }
+
+glm::vec2 WaveNbAttribute::get_value_at(float time) const
+{
+  glm::vec2 out;
+  this->track.evaluate(time, &out.x, &this->value.x);
+  return out;
+}
+
+void WaveNbAttribute::get_values_at(std::span<const float> times, float *out) const
+{
+  this->track.evaluate(times, out, &this->value.x);
+}
+
 void WaveNbAttribute::json_from(nlohmann::json const &json)
 {
-  AbstractAttribute::json_from(json);
-  json_safe_get(json, "value", value);
-  json_safe_get(json, "vmin", vmin);
-  json_safe_get(json, "vmax", vmax);
-  json_safe_get(json, "link_xy", link_xy);
+  ATTR_TRACE_SCOPE("WaveNbAttribute::json_from");
+
+  using Schema = JsonSchema<WaveNbAttribute>;
+
+  static const Schema schema = {
+      Schema::member<&WaveNbAttribute::value>("value"),
+      Schema::member<&WaveNbAttribute::vmin>("vmin"),
+      Schema::member<&WaveNbAttribute::vmax>("vmax"),
+      Schema::member<&WaveNbAttribute::link_xy>("link_xy"),
+      {"keyframes",
+       [](WaveNbAttribute &a, const nlohmann::json &j) { a.track.json_from(j); },
+       false}};
+
+  this->bump_version();
+  this->track.clear();
+  schema.read(json, *this);
 }
 
 nlohmann::json WaveNbAttribute::json_to() const
 {
+  ATTR_TRACE_SCOPE("WaveNbAttribute::json_to");
+
   nlohmann::json json = AbstractAttribute::json_to();
   json["value"] = {this->value.x, this->value.y};
   json["vmin"] = this->vmin;
   json["vmax"] = this->vmax;
   json["link_xy"] = this->link_xy;
+
+  if (!this->track.empty())
+    json["keyframes"] = this->track.json_to();
+
   return json;
 }
 
-void WaveNbAttribute::set_link_xy(const bool new_state) { this->link_xy = new_state; }
+uint64_t WaveNbAttribute::hash() const
+{
+  uint64_t h = hash_value(this->value);
+  return this->track.empty() ? h : hash_combine(h, this->track.hash());
+}
+
+MemoryUsage WaveNbAttribute::memory_usage() const
+{
+  MemoryUsage usage = AbstractAttribute::memory_usage();
+  usage.metadata += sizeof(*this);
+  usage.value += this->track.memory_usage();
+  return usage;
+}
 
-void WaveNbAttribute::set_value(const glm::vec2 &new_value) { this->value = new_value; }
+void WaveNbAttribute::set_link_xy(const bool new_state)
+{
+  this->link_xy = new_state;
+  this->bump_version();
+}
+
+void WaveNbAttribute::set_value(const glm::vec2 &new_value)
+{
+  this->value = new_value;
+  this->bump_version();
+}
 
 std::string WaveNbAttribute::to_string()
 {
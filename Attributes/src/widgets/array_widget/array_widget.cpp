@@ -6,6 +6,7 @@
 #include <QLabel>
 #include <QPushButton>
 
+#include "attributes/trace.hpp"
 #include "attributes/widgets/float_widget.hpp"
 
 #include "highmap/filters.hpp"
@@ -52,6 +53,8 @@ ArrayWidget::ArrayWidget(ArrayAttribute *p_attr) : p_attr(p_attr)
 
 void ArrayWidget::array_data_to_widget_field_data()
 {
+  ATTR_TRACE_SCOPE("ArrayWidget::array_data_to_widget_field_data");
+
   // set widget field data from attribute array data
   hmap::Array array = this->p_attr->get_value();
   hmap::remap(array);
@@ -67,10 +70,10 @@ void ArrayWidget::on_canvas_edit_ended()
   hmap::Array array(shape_canvas);
   array.vector = this->canvas->get_field_data();
 
-  *this->p_attr->get_value_ref() = array.resample_to_shape_bicubic(
+  *this->p_attr->edit_value() = array.resample_to_shape_bicubic(
       this->p_attr->get_shape());
 
-  this->p_attr->get_value_ref()->dump();
+  this->p_attr->get_value_cref().dump();
 
   Q_EMIT this->value_changed();
 }
@@ -2,7 +2,6 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #include <format>
-#include <fstream>
 
 #include <QFileDialog>
 #include <QFont>
@@ -12,6 +11,8 @@
 #include <QPushButton>
 #include <QVBoxLayout>
 
+#include "attributes/preset_io.hpp"
+#include "attributes/trace.hpp"
 #include "attributes/widgets/attributes_widget.hpp"
 #include "attributes/widgets/widget_utils.hpp"
 
@@ -45,6 +46,8 @@ namespace attr
 
 AbstractWidget *get_attribute_widget(AbstractAttribute *p_attr)
 {
+  ATTR_TRACE_SCOPE("get_attribute_widget");
+
   RETURN_IF_MATCH(BOOL, BoolWidget, BoolAttribute, p_attr);
   RETURN_IF_MATCH(CHOICE, ChoiceWidget, ChoiceAttribute, p_attr);
   RETURN_IF_MATCH(COLOR, ColorWidget, ColorAttribute, p_attr);
@@ -78,6 +81,8 @@ AttributesWidget::AttributesWidget(
     QWidget   *parent)
     : QWidget(parent), p_attr_map(p_attr_map), p_attr_ordered_key(p_attr_ordered_key)
 {
+  ATTR_TRACE_SCOPE("AttributesWidget::AttributesWidget");
+
   std::string title = widget_title.empty() ? "Attribute settings" : widget_title;
   this->setWindowTitle(title.c_str());
 
@@ -264,6 +269,8 @@ AttributesWidget::AttributesWidget(
         "Missing attributes in AttributesWidget (check attr_ordered_key)");
   }
 
+  ATTR_TRACE_COUNTER("AttributesWidget::widgets", count);
+
   // As a last resort, for empty "settings"
   if (p_attr_map->empty())
   {
@@ -277,6 +284,21 @@ AttributesWidget::AttributesWidget(
   this->setLayout(layout);
 }
 
+void AttributesWidget::flush_autosave()
+{
+  if (this->autosave_timer && this->autosave_timer->isActive())
+    this->on_autosave();
+}
+
+void AttributesWidget::on_autosave()
+{
+  if (this->autosave_timer)
+    this->autosave_timer->stop();
+
+  if (this->journal)
+    this->journal->save(*this->p_attr_map);
+}
+
 void AttributesWidget::on_load_preset()
 {
   Logger::log()->trace("AttributesWidget::on_load_preset");
@@ -287,33 +309,14 @@ void AttributesWidget::on_load_preset()
                                                "json file (*.json)");
 
   if (!fname.isNull() && !fname.isEmpty())
-  {
-    nlohmann::json json;
-    std::ifstream  file(fname.toStdString());
-
-    if (file.is_open())
-    {
-      file >> json;
-      file.close();
-      Logger::log()->trace("JSON successfully loaded from {}", fname.toStdString());
-
-      for (auto &[key, pa] : *this->p_attr_map)
-      {
-        // do some checking before deserializing the data
-        if (json.contains(key) && json[key]["type_string"] == pa->get_type_string())
-        {
-          // use save/restore state to update widget (quick and dirty)
-          pa->json_from(json[key]);
-          pa->save_state();
-          this->widget_map.at(key)->reset_value();
-        }
-        else
-          Logger::log()->error("Could not load preset for parameter: {}", key);
-      }
-    }
-    else
-      Logger::log()->error("Could not open file {} to load JSON", fname.toStdString());
-  }
+    load_preset(fname.toStdString(),
+                *this->p_attr_map,
+                [this](const std::string &key)
+                {
+                  // use save/restore state to update widget (quick and dirty)
+                  this->p_attr_map->at(key)->save_state();
+                  this->widget_map.at(key)->reset_value();
+                });
 }
 
 void AttributesWidget::on_restore_initial_state()
@@ -350,21 +353,7 @@ void AttributesWidget::on_save_preset()
                                                "json file (*.json)");
 
   if (!fname.isNull() && !fname.isEmpty())
-  {
-    nlohmann::json json;
-    for (auto &[key, pa] : *this->p_attr_map)
-      json[key] = pa->json_to();
-
-    std::ofstream file(fname.toStdString());
-
-    if (file.is_open())
-    {
-      file << json.dump(4);
-      file.close();
-    }
-    else
-      Logger::log()->error("Could not open file {} to save JSON", fname.toStdString());
-  }
+    save_preset(fname.toStdString(), *this->p_attr_map);
 }
 
 void AttributesWidget::on_save_state()
@@ -373,6 +362,122 @@ void AttributesWidget::on_save_state()
 
   for (auto &[key, pa] : *p_attr_map)
     pa->save_state();
+
+  this->on_update_memory_overlay();
+}
+
+void AttributesWidget::on_update_memory_overlay()
+{
+  if (this->memory_timer)
+    this->memory_timer->stop();
+
+  if (!this->memory_label)
+    return;
+
+  MemoryReport report = memory_usage_attributes(*this->p_attr_map);
+  this->memory_label->setText(report.to_string().c_str());
+}
+
+void AttributesWidget::set_autosave_journal(const std::string &fname, bool load)
+{
+  Logger::log()->trace("AttributesWidget::set_autosave_journal: {}", fname);
+
+  this->disconnect(this->autosave_connection);
+
+  // the pending changes go to the previous journal
+  this->flush_autosave();
+
+  this->journal.reset();
+
+  if (fname.empty())
+    return;
+
+  if (!this->autosave_timer)
+  {
+    this->autosave_timer = new QTimer(this);
+    this->autosave_timer->setSingleShot(true);
+    this->autosave_timer->setInterval(ATTR_AUTOSAVE_DELAY_MS);
+
+    this->connect(this->autosave_timer,
+                  &QTimer::timeout,
+                  this,
+                  &AttributesWidget::on_autosave);
+  }
+
+  this->journal = std::make_unique<PresetJournal>(fname);
+
+  if (load)
+    this->journal->load(*this->p_attr_map,
+                        [this](const std::string &key)
+                        {
+                          // use save/restore state to update widget (quick and dirty)
+                          this->p_attr_map->at(key)->save_state();
+                          this->widget_map.at(key)->reset_value();
+                        });
+
+  // not restarted by the following changes, a continuous edit is still saved
+  // periodically
+  this->autosave_connection = this->connect(this,
+                                            &AttributesWidget::value_changed,
+                                            this,
+                                            [this]()
+                                            {
+                                              if (!this->autosave_timer->isActive())
+                                                this->autosave_timer->start();
+                                            });
+}
+
+void AttributesWidget::set_memory_overlay(bool enabled)
+{
+  Logger::log()->trace("AttributesWidget::set_memory_overlay: {}", enabled);
+
+  this->disconnect(this->memory_connection);
+
+  if (!enabled)
+  {
+    delete this->memory_label;
+    this->memory_label = nullptr;
+
+    if (this->memory_timer)
+      this->memory_timer->stop();
+    return;
+  }
+
+  if (!this->memory_timer)
+  {
+    this->memory_timer = new QTimer(this);
+    this->memory_timer->setSingleShot(true);
+    this->memory_timer->setInterval(ATTR_MEMORY_OVERLAY_DELAY_MS);
+
+    this->connect(this->memory_timer,
+                  &QTimer::timeout,
+                  this,
+                  &AttributesWidget::on_update_memory_overlay);
+  }
+
+  if (!this->memory_label)
+  {
+    this->memory_label = new QLabel(this);
+
+    QFont font = this->memory_label->font();
+    font.setFamily("monospace");
+    font.setStyleHint(QFont::Monospace);
+    this->memory_label->setFont(font);
+    this->memory_label->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    this->layout()->addWidget(this->memory_label);
+  }
+
+  // the report walks the saved states of every attribute, throttled while editing
+  this->memory_connection = this->connect(this,
+                                          &AttributesWidget::value_changed,
+                                          this,
+                                          [this]()
+                                          {
+                                            if (!this->memory_timer->isActive())
+                                              this->memory_timer->start();
+                                          });
+  this->on_update_memory_overlay();
 }
 
 QSize AttributesWidget::sizeHint() const
@@ -7,6 +7,7 @@
 #include <QPushButton>
 
 #include "attributes/widgets/cloud_widget.hpp"
+#include "attributes/widgets/point_import_task.hpp"
 #include "attributes/widgets/widget_utils.hpp"
 
 namespace attr
@@ -70,29 +71,36 @@ CloudWidget::CloudWidget(CloudAttribute *p_attr) : p_attr(p_attr)
 
 void CloudWidget::clear_points()
 {
-  std::vector<float> x, y, z;
-  this->p_attr->set_value(hmap::Cloud(x, y, z));
+  this->p_attr->set_buffers({}, {}, {});
   this->update_canvas_from_attribute();
   Q_EMIT this->value_changed();
 }
 
 void CloudWidget::load_points_from_csv()
 {
-  QString fname = QFileDialog::getOpenFileName(this, "", "", "CSV file (*.csv)");
+  QString fname = QFileDialog::getOpenFileName(this,
+                                               "",
+                                               "",
+                                               "Point file (*.csv *.bin)");
 
   if (!fname.isNull() && !fname.isEmpty())
-  {
-    this->p_attr->get_value_ref()->from_csv(fname.toStdString());
-    this->update_canvas_from_attribute();
-    Q_EMIT this->value_changed();
-  }
+    import_points_async(this,
+                        fname.toStdString(),
+                        [this](CloudBuffers &&buffers)
+                        {
+                          this->p_attr->set_buffers(std::move(buffers.x),
+                                                    std::move(buffers.y),
+                                                    std::move(buffers.v));
+                          this->update_canvas_from_attribute();
+                          Q_EMIT this->value_changed();
+                        });
 }
 
 void CloudWidget::randomize_points()
 {
-  if (this->p_attr->get_value().size())
+  if (this->p_attr->get_npoints())
   {
-    this->p_attr->get_value_ref()->randomize((uint)time(NULL));
+    this->p_attr->edit_value()->randomize((uint)time(NULL));
     this->update_canvas_from_attribute();
     Q_EMIT this->value_changed();
   }
@@ -110,18 +118,17 @@ void CloudWidget::reset_value(bool reset_to_initial_state)
 
 void CloudWidget::update_attribute_from_canvas()
 {
-  std::vector<float> x = this->canvas->get_points_x();
-  std::vector<float> y = this->canvas->get_points_y();
-  std::vector<float> z = this->canvas->get_points_z();
-  this->p_attr->set_value(hmap::Cloud(x, y, z));
+  // canvas buffers moved to the attribute, no copy
+  this->p_attr->set_buffers(this->canvas->get_points_x(),
+                            this->canvas->get_points_y(),
+                            this->canvas->get_points_z());
   Q_EMIT this->value_changed();
 }
 
 void CloudWidget::update_canvas_from_attribute()
 {
-  this->canvas->set_points(this->p_attr->get_value().get_x(),
-                           this->p_attr->get_value().get_y(),
-                           this->p_attr->get_value().get_values());
+  const CloudBuffers &b = this->p_attr->get_buffers();
+  this->canvas->set_points(b.x, b.y, b.v);
 }
 
 } // namespace attr
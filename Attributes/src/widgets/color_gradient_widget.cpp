@@ -194,20 +194,22 @@ void ColorGradientWidget::update_widget_from_attribute()
 
 void ColorGradientWidget::update_attribute_from_widget()
 {
-  // update attribute value
-  std::vector<Stop> *p_value = this->p_attr->get_value_ref();
-  p_value->clear();
+  // update attribute value, the version is bumped once the stops are written
+  {
+    auto value = this->p_attr->edit_value();
+    value->clear();
 
-  QVector<qsx::Stop> stops = this->picker->get_stops();
+    QVector<qsx::Stop> stops = this->picker->get_stops();
 
-  for (const auto &stop : stops)
-  {
-    Stop new_value = {(float)stop.position,
-                      stop.color.redF(),
-                      stop.color.greenF(),
-                      stop.color.blueF(),
-                      stop.color.alphaF()};
-    p_value->push_back(new_value);
+    for (const auto &stop : stops)
+    {
+      Stop new_value = {(float)stop.position,
+                        stop.color.redF(),
+                        stop.color.greenF(),
+                        stop.color.blueF(),
+                        stop.color.alphaF()};
+      value->push_back(new_value);
+    }
   }
 
   Q_EMIT this->value_changed();
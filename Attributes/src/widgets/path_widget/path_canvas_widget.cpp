@@ -6,6 +6,7 @@
 #include <QPainter>
 
 #include "attributes/widgets/path_widget.hpp"
+#include "attributes/widgets/point_import_task.hpp"
 
 namespace attr
 {
@@ -83,14 +84,23 @@ int PathCanvasWidget::get_hovered_point_index(const QPointF &pos)
 
 void PathCanvasWidget::load_from_csv()
 {
-  QString fname = QFileDialog::getOpenFileName(this, "", "", "CSV file (*.csv)");
+  QString fname = QFileDialog::getOpenFileName(this,
+                                               "",
+                                               "",
+                                               "Point file (*.csv *.bin)");
 
   if (!fname.isNull() && !fname.isEmpty())
-  {
-    this->p_attr->get_value_ref()->from_csv(fname.toStdString());
-    this->update_widget_from_attribute();
-    this->update();
-  }
+    import_points_async(this,
+                        fname.toStdString(),
+                        [this](CloudBuffers &&buffers)
+                        {
+                          this->p_attr->set_buffers(std::move(buffers.x),
+                                                    std::move(buffers.y),
+                                                    std::move(buffers.v));
+                          this->update_widget_from_attribute();
+                          this->update();
+                          Q_EMIT this->value_changed();
+                        });
 }
 
 QPointF PathCanvasWidget::map_to_value(const QPointF &widget_point)
@@ -246,8 +256,8 @@ void PathCanvasWidget::paintEvent(QPaintEvent * /* event */)
   // add inner ellipse based on the value associated to the point
   if (this->qpoints.size() > 0)
   {
-    float vmin = this->p_attr->get_value_ref()->get_values_min();
-    float vmax = this->p_attr->get_value_ref()->get_values_max();
+    float vmin = this->p_attr->get_value_cref().get_values_min();
+    float vmax = this->p_attr->get_value_cref().get_values_max();
     float inv_vptp = vmin == vmax ? 0.f : 1.f / (vmax - vmin);
 
     painter.setBrush(QBrush(Qt::darkGray));
@@ -263,10 +273,14 @@ void PathCanvasWidget::paintEvent(QPaintEvent * /* event */)
 
 void PathCanvasWidget::randomize()
 {
-  if (this->p_attr->get_value_ref()->size())
+  if (this->p_attr->get_value_cref().size())
   {
-    this->p_attr->get_value_ref()->randomize((uint)time(NULL));
-    this->p_attr->get_value_ref()->reorder_nns();
+    {
+      auto path = this->p_attr->edit_value();
+      path->randomize((uint)time(NULL));
+      path->reorder_nns();
+    }
+
     this->update_widget_from_attribute();
     this->update();
     Q_EMIT this->value_changed();
@@ -275,7 +289,7 @@ void PathCanvasWidget::randomize()
 
 void PathCanvasWidget::reorder_nns()
 {
-  this->p_attr->get_value_ref()->reorder_nns();
+  this->p_attr->edit_value()->reorder_nns();
   this->update_widget_from_attribute();
   this->update();
   Q_EMIT this->value_changed();
@@ -283,9 +297,9 @@ void PathCanvasWidget::reorder_nns()
 
 void PathCanvasWidget::reverse()
 {
-  if (this->p_attr->get_value_ref()->size())
+  if (this->p_attr->get_value_cref().size())
   {
-    this->p_attr->get_value_ref()->reverse();
+    this->p_attr->edit_value()->reverse();
     this->update_widget_from_attribute();
     this->update();
     Q_EMIT this->value_changed();
@@ -315,7 +329,7 @@ void PathCanvasWidget::update_widget_from_attribute()
   this->qpoints.clear();
   this->qvalues.clear();
 
-  for (auto &p : this->p_attr->get_value_ref()->points)
+  for (auto &p : this->p_attr->get_value_cref().points)
   {
     QPointF pos = this->map_to_widget(QPointF(p.x, p.y));
     this->qpoints.push_back(pos);
@@ -0,0 +1,118 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <atomic>
+#include <memory>
+
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QProgressDialog>
+#include <QtConcurrent>
+
+#include "attributes/widgets/point_import_task.hpp"
+
+namespace attr
+{
+
+// helpers
+
+// Shared between the GUI thread and the import thread
+struct PointImportState
+{
+  std::atomic<bool> canceled = false;
+  int               progress = 0; // import thread only, last reported percentage
+  CloudBuffers      buffers;
+};
+
+// Import running on the thread pool, owned by the parent widget: destroying the widget
+// cancels the import and waits for it to end, the import never outlives its parent
+class PointImportTask : public QFutureWatcher<bool>
+{
+public:
+  PointImportTask(QWidget *parent, std::shared_ptr<PointImportState> state)
+      : QFutureWatcher<bool>(parent), state(state)
+  {
+  }
+
+  ~PointImportTask() override
+  {
+    this->state->canceled = true;
+    this->waitForFinished();
+  }
+
+private:
+  std::shared_ptr<PointImportState> state;
+};
+
+// functions
+
+void import_points_async(QWidget                              *parent,
+                         const std::string                    &fname,
+                         std::function<void(CloudBuffers &&)> done_fct)
+{
+  auto state = std::make_shared<PointImportState>();
+
+  QProgressDialog *dialog = new QProgressDialog("Importing points...",
+                                                "Cancel",
+                                                0,
+                                                100,
+                                                parent);
+  dialog->setWindowModality(Qt::WindowModal);
+  dialog->setMinimumDuration(500);
+  dialog->setAttribute(Qt::WA_DeleteOnClose);
+
+  QObject::connect(dialog,
+                   &QProgressDialog::canceled,
+                   [state]() { state->canceled = true; });
+  QObject::connect(dialog,
+                   &QObject::destroyed,
+                   [state]() { state->canceled = true; });
+
+  PointImportTask          *task = new PointImportTask(parent, state);
+  QPointer<QProgressDialog> dialog_ptr(dialog);
+
+  // the task outlives the import (see PointImportTask), calls queued on it from the
+  // import thread are discarded if it is deleted before they are processed
+  auto progress_fct = [state, task, dialog_ptr](float progress)
+  {
+    int percent = static_cast<int>(100.f * progress);
+
+    if (percent != state->progress)
+    {
+      state->progress = percent;
+      QMetaObject::invokeMethod(
+          task,
+          [dialog_ptr, percent]()
+          {
+            if (dialog_ptr)
+              dialog_ptr->setValue(percent);
+          },
+          Qt::QueuedConnection);
+    }
+
+    return !state->canceled;
+  };
+
+  QObject::connect(task,
+                   &QFutureWatcher<bool>::finished,
+                   task,
+                   [task, state, dialog_ptr, done_fct]()
+                   {
+                     // before closing the dialog, which reports a cancellation
+                     bool is_done = task->result() && !state->canceled;
+
+                     if (dialog_ptr)
+                       dialog_ptr->close();
+
+                     if (is_done && done_fct)
+                       done_fct(std::move(state->buffers));
+
+                     task->deleteLater();
+                   });
+
+  task->setFuture(QtConcurrent::run(
+      [state, fname, progress_fct]()
+      { return import_points(fname, state->buffers, progress_fct); }));
+}
+
+} // namespace attr
@@ -10,7 +10,8 @@
 namespace attr
 {
 
-RangeWidget::RangeWidget(RangeAttribute *p_attr) : p_attr(p_attr)
+RangeWidget::RangeWidget(RangeAttribute *p_attr)
+    : p_attr(p_attr), histogram_state(std::make_shared<HistogramWorkerState>())
 {
   this->set_tool_tip_fct([p_attr]() { return p_attr ? p_attr->get_description() : ""; });
 
@@ -27,7 +28,20 @@ RangeWidget::RangeWidget(RangeAttribute *p_attr) : p_attr(p_attr)
                                       this->p_attr->get_vmax(),
                                       this->p_attr->get_value_format());
 
-  this->slider->set_histogram_fct(this->p_attr->get_histogram_fct());
+  // the slider only displays the last valid histogram, the actual computation is done
+  // asynchronously (see on_update_bins)
+  if (this->p_attr->get_histogram_fct())
+  {
+    std::shared_ptr<HistogramWorkerState> state = this->histogram_state;
+
+    this->slider->set_histogram_fct(
+        [state]()
+        {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          return state->histogram;
+        });
+  }
+
   this->slider->set_autorange(this->p_attr->get_autorange());
   this->slider->set_is_enabled(this->p_attr->get_is_active());
 
@@ -36,14 +50,91 @@ RangeWidget::RangeWidget(RangeAttribute *p_attr) : p_attr(p_attr)
                 this,
                 &RangeWidget::update_attribute_from_widget);
 
-  this->connect(this,
-                &RangeWidget::update_bins,
-                this->slider,
-                &qsx::SliderRange::on_update_bins);
+  this->connect(this, &RangeWidget::update_bins, this, &RangeWidget::on_update_bins);
 
   // eventually update overall widget enabled/disabled state
   layout->addWidget(this->slider);
   this->setLayout(layout);
+
+  this->on_update_bins();
+}
+
+RangeWidget::~RangeWidget()
+{
+  // the running computation is cancelled (see RangeAttribute::set_histogram_fct), the
+  // worker then stops and discards its result
+  {
+    std::lock_guard<std::mutex> lock(this->histogram_state->mutex);
+    this->histogram_state->widget_alive = false;
+    this->histogram_state->is_cancelled = true;
+  }
+
+  // the histogram function may use data owned by the widget owner, it must not be
+  // running once the widget is gone
+  if (this->histogram_worker.joinable())
+    this->histogram_worker.join();
+}
+
+void RangeWidget::on_histogram_ready(uint64_t generation)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->histogram_state->mutex);
+    if (generation != this->histogram_state->generation)
+      return;
+  }
+
+  // the slider reads the histogram through the cached function (see constructor)
+  this->slider->on_update_bins();
+}
+
+void RangeWidget::on_update_bins()
+{
+  HistogramFct histogram_fct = this->p_attr->get_histogram_fct();
+
+  if (!histogram_fct)
+    return;
+
+  std::function<uint64_t()> version_fct = this->p_attr->get_histogram_version_fct();
+  HistogramWorkerState     &state = *this->histogram_state;
+
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  if (version_fct)
+  {
+    // source data unchanged since the latest request, the current (or in-flight)
+    // histogram is still valid
+    uint64_t version = version_fct();
+
+    if (state.has_source_version && state.source_version == version)
+      return;
+
+    state.has_source_version = true;
+    state.source_version = version;
+  }
+  else
+    state.has_source_version = false;
+
+  state.generation++;
+  state.histogram_fct = histogram_fct;
+
+  // the worker picks up the latest request once it is done with the current one,
+  // which is cancelled, intermediate requests are dropped
+  if (state.worker_running)
+  {
+    state.pending = true;
+    state.is_cancelled = true;
+    return;
+  }
+
+  // the previous worker cleared worker_running as its last step under the lock, it
+  // has returned or is about to
+  if (this->histogram_worker.joinable())
+    this->histogram_worker.join();
+
+  state.worker_running = true;
+  this->histogram_worker = std::thread(&RangeWidget::run_histogram_worker,
+                                       this->histogram_state,
+                                       this);
 }
 
 void RangeWidget::reset_value(bool reset_to_initial_state)
@@ -58,6 +149,71 @@ void RangeWidget::reset_value(bool reset_to_initial_state)
   this->slider->set_is_enabled(this->p_attr->get_is_active());
 }
 
+void RangeWidget::run_histogram_worker(std::shared_ptr<HistogramWorkerState> state,
+                                       RangeWidget                          *p_widget)
+{
+  while (true)
+  {
+    HistogramFct histogram_fct;
+    uint64_t     generation;
+
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+
+      if (!state->widget_alive)
+      {
+        state->worker_running = false;
+        return;
+      }
+
+      histogram_fct = state->histogram_fct;
+      generation = state->generation;
+      state->pending = false;
+      state->is_cancelled = false;
+    }
+
+    PairVec histogram;
+    bool    success = true;
+
+    try
+    {
+      histogram = histogram_fct(state->is_cancelled);
+    }
+    catch (const std::exception &e)
+    {
+      Logger::log()->error("RangeWidget::run_histogram_worker: histogram computation "
+                           "failed: {}",
+                           e.what());
+      success = false;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+
+    if (state->widget_alive && generation == state->generation)
+    {
+      if (success)
+      {
+        state->histogram = std::move(histogram);
+
+        // the widget cannot be deleted while the state is locked, and queued calls are
+        // discarded by Qt if the widget is deleted before they are processed
+        QMetaObject::invokeMethod(
+            p_widget,
+            [p_widget, generation]() { p_widget->on_histogram_ready(generation); },
+            Qt::QueuedConnection);
+      }
+      else
+        state->has_source_version = false; // allow a retry with the same source
+    }
+
+    if (!state->widget_alive || !state->pending)
+    {
+      state->worker_running = false;
+      return;
+    }
+  }
+}
+
 void RangeWidget::update_attribute_from_widget()
 {
   float     x1 = this->slider->get_value(0);
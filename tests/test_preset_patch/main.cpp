@@ -0,0 +1,208 @@
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "attributes.hpp"
+
+// Headless round trips of the binary formats: preset patches (diff, serialize,
+// deserialize, apply), compression codecs and binary presets, including truncated and
+// corrupted data which must be rejected without crashing. Returns the number of failed
+// checks.
+
+using AttrMap = std::map<std::string, std::unique_ptr<attr::AbstractAttribute>>;
+
+static int nfailed = 0;
+
+static void check(bool condition, const std::string &what)
+{
+  std::printf("%s: %s\n", condition ? "ok    " : "FAILED", what.c_str());
+  if (!condition)
+    nfailed++;
+}
+
+static AttrMap make_map()
+{
+  AttrMap map;
+  map["float"] = std::make_unique<attr::FloatAttribute>("Float", 0.5f, 0.f, 1.f);
+  map["int"] = std::make_unique<attr::IntAttribute>("Int", 3, 0, 10);
+  map["array"] = std::make_unique<attr::ArrayAttribute>("Array", glm::ivec2(100, 70));
+  map["bool"] = std::make_unique<attr::BoolAttribute>("Bool", true);
+  map["vec"] = std::make_unique<attr::VecFloatAttribute>("Vec",
+                                                         std::vector<float>{1.f, 2.f},
+                                                         0.f,
+                                                         1.f);
+  return map;
+}
+
+static bool same_states(const AttrMap &map_a, const AttrMap &map_b)
+{
+  for (auto &[key, p_attr] : map_b)
+    if (!map_a.contains(key) || map_a.at(key)->json_to() != p_attr->json_to())
+      return false;
+  return true;
+}
+
+static void test_patch()
+{
+  AttrMap map_a = make_map();
+  AttrMap map_b = make_map();
+
+  map_b["float"]->get_ref<attr::FloatAttribute>()->set_value(0.8f);
+  map_b["int"]->set_label("Renamed"); // head only, same value digest
+  {
+    auto scope = map_b["array"]->get_ref<attr::ArrayAttribute>()->edit_value();
+    scope->vector[5 * 100 + 40] = 1.f;
+    scope->vector[69 * 100 + 99] = -1.f;
+  }
+  map_b["vec"]->get_ref<attr::VecFloatAttribute>()->edit_value()->push_back(0.5f);
+
+  attr::PresetPatch patch = attr::diff_attributes(map_a, map_b);
+  check(patch.size() == 4, "diff finds the changed attributes, labels included");
+  check(!patch.get_entries().contains("bool"), "diff skips unchanged attributes");
+
+  std::vector<char> bytes = patch.serialize();
+
+  attr::PresetPatch patch_read;
+  check(patch_read.deserialize(bytes.data(), bytes.size()), "deserialize");
+  check(patch_read.apply(map_a), "apply");
+  check(same_states(map_a, map_b), "patched states match");
+  check(attr::diff_attributes(map_a, map_b).empty(), "no diff after apply");
+
+  // every truncation must be rejected
+  bool is_rejected = true;
+  for (size_t size = 0; size < bytes.size(); size++)
+  {
+    attr::PresetPatch p;
+    is_rejected &= !p.deserialize(bytes.data(), size) && p.empty();
+  }
+  check(is_rejected, "truncated patches are rejected");
+
+  // random byte corruptions must either be rejected or leave a patch which applies
+  // safely
+  for (size_t k = 0; k < bytes.size(); k += 7)
+  {
+    std::vector<char> corrupted = bytes;
+    corrupted[k] ^= 0x5a;
+
+    attr::PresetPatch p;
+    if (p.deserialize(corrupted.data(), corrupted.size()))
+    {
+      AttrMap map = make_map();
+      p.apply(map);
+    }
+  }
+  check(true, "corrupted patches are handled");
+
+  // blocks reaching beyond 64 bits must be rejected, not wrapped around
+  attr::PatchEntry e;
+  e.type = attr::AttributeType::HMAP_ARRAY;
+  e.blocks.push_back({"vector", 1, 3, 2, UINT64_MAX / 2, {0.f, 0.f, 0.f, 0.f, 0.f, 0.f}});
+
+  attr::PresetPatch patch_overflow;
+  patch_overflow.set_entry("array", std::move(e));
+  bytes = patch_overflow.serialize();
+
+  attr::PresetPatch p;
+  check(!p.deserialize(bytes.data(), bytes.size()), "overflowing blocks are rejected");
+  check(!patch_overflow.apply(map_a), "overflowing blocks are not applied");
+}
+
+static void test_codecs()
+{
+  std::vector<float> values(10000);
+  for (size_t k = 0; k < values.size(); k++)
+    values[k] = std::sin(0.01f * float(k));
+
+  for (auto codec : {attr::CompressionCodec::NONE,
+                     attr::CompressionCodec::LZ4,
+                     attr::CompressionCodec::ZSTD})
+  {
+    if (!attr::is_codec_available(codec))
+      continue;
+
+    for (auto filter : {attr::CompressionFilter::NONE,
+                        attr::CompressionFilter::SHUFFLE,
+                        attr::CompressionFilter::DELTA_SHUFFLE})
+    {
+      std::string what = "codec " + std::to_string(int(codec)) + " filter " +
+                         std::to_string(int(filter));
+
+      std::vector<char> packed;
+      bool              ret = attr::compress_floats({codec, filter, 0},
+                                       values.data(),
+                                       values.size(),
+                                       packed);
+
+      std::vector<float> unpacked(values.size());
+      ret = ret && attr::decompress_floats(codec,
+                                           filter,
+                                           packed.data(),
+                                           packed.size(),
+                                           unpacked.data(),
+                                           unpacked.size());
+      check(ret && unpacked == values, what + " round trip");
+
+      if (codec != attr::CompressionCodec::NONE && packed.size() > 1)
+      {
+        bool is_rejected = !attr::decompress_floats(codec,
+                                                    filter,
+                                                    packed.data(),
+                                                    packed.size() / 2,
+                                                    unpacked.data(),
+                                                    unpacked.size());
+        check(is_rejected, what + " truncated data are rejected");
+      }
+    }
+  }
+}
+
+static void test_archive()
+{
+  std::string fname = (std::filesystem::temp_directory_path() / "test_preset_patch.bin")
+                          .string();
+
+  AttrMap map_a = make_map();
+  {
+    auto scope = map_a["array"]->get_ref<attr::ArrayAttribute>()->edit_value();
+    for (size_t k = 0; k < scope->vector.size(); k++)
+      scope->vector[k] = float(k % 13);
+  }
+
+  check(attr::save_preset_archive(fname, map_a), "save archive");
+
+  {
+    AttrMap             map_b = make_map();
+    attr::PresetArchive archive(fname);
+    check(archive.is_open() && archive.load(map_b), "load archive");
+    check(same_states(map_b, map_a), "archive states match");
+  }
+
+  // truncated files must be rejected (or their attributes fail to load)
+  std::vector<char> bytes(std::filesystem::file_size(fname));
+  std::ifstream(fname, std::ios::binary).read(bytes.data(), bytes.size());
+
+  for (size_t size : {size_t(0), size_t(16), bytes.size() / 2, bytes.size() - 1})
+  {
+    std::ofstream(fname, std::ios::binary | std::ios::trunc).write(bytes.data(), size);
+
+    AttrMap             map_b = make_map();
+    attr::PresetArchive archive(fname);
+    check(!archive.is_open() || !archive.load(map_b),
+          "archive truncated to " + std::to_string(size) + " bytes is rejected");
+  }
+
+  std::filesystem::remove(fname);
+}
+
+int main()
+{
+  attr::Logger::log()->set_level(spdlog::level::off); // corrupted data are logged
+
+  test_patch();
+  test_codecs();
+  test_archive();
+
+  std::printf("%d failed check(s)\n", nfailed);
+  return nfailed;
+}
@@ -0,0 +1,928 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+// attr-preset - headless tool to validate, convert, diff, merge and benchmark attribute
+// presets, JSON or binary (see PresetArchive). Directories are searched recursively and
+// their files processed in parallel.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/sinks/base_sink.h>
+
+#include "attributes.hpp"
+
+namespace fs = std::filesystem;
+
+static const char *usage_text = R"(usage: attr-preset <command> [options] <inputs...>
+
+Inputs are preset files (JSON or binary, the format is detected from the content) or
+directories, searched recursively for *.json and *.bin files.
+
+commands:
+  validate <inputs...>          check that the presets are well-formed and load into
+                                attributes without errors
+  convert -o <output> <inputs...>
+                                convert the presets, <output> is a file for a single
+                                input file, a directory otherwise (the input tree is
+                                mirrored)
+  diff <a> <b>                  list the attributes that differ between two presets
+  merge -o <output> <inputs...> merge the presets, the attributes of the later ones
+                                replace the earlier ones
+  bench <inputs...>             time the loading of the presets into attributes
+                                (load_preset, PresetArchive::load), the attributes are
+                                created beforehand from a first read
+  bench-read <inputs...>        time the reading of the presets as JSON trees (JSON
+                                parsing, binary presets decoding with
+                                PresetArchive::get_json)
+
+options:
+  -o, --output <path>           output file or directory
+  --to <json|bin>               output format (default: from the output extension,
+                                binary unless .json)
+  --codec <none|lz4|zstd>       compression of the binary presets (default: none)
+  --filter <none|shuffle|delta> filter applied before compression (default: delta)
+  --level <n>                   compression level (default: codec default)
+  --repeat <n>                  bench, number of loads/reads per preset (default: 3)
+  -j, --jobs <n>                number of worker threads (default: all the cores, use 1
+                                for single-threaded bench timings)
+  -q, --quiet                   only report failures
+  -h, --help                    show this help
+
+The exit status is 0 on success, 1 if a preset failed or differs (diff), 2 on usage
+errors.
+)";
+
+// helpers
+
+enum class OutputFormat
+{
+  AUTO,
+  JSON,
+  ARCHIVE,
+};
+
+struct Options
+{
+  std::string               command;
+  std::vector<std::string>  inputs;
+  std::string               output;
+  OutputFormat              format = OutputFormat::AUTO;
+  attr::CompressionSettings compression;
+  size_t                    njobs = 0; // 0 for the hardware concurrency
+  int                       repeat = 3;
+  bool                      quiet = false;
+};
+
+using AttrMap = std::map<std::string, std::unique_ptr<attr::AbstractAttribute>>;
+
+struct InputFile
+{
+  fs::path path;
+  fs::path relative; // to the input directory, file name for a file input
+};
+
+// outcome of the processing of one input file
+struct FileResult
+{
+  bool        ok = true;
+  std::string message;
+};
+
+static bool parse_options(int argc, char *argv[], Options &options)
+{
+  if (argc < 2)
+    return false;
+
+  options.command = argv[1];
+
+  for (int k = 2; k < argc; k++)
+  {
+    std::string arg = argv[k];
+
+    auto next = [&]() -> const char * { return k + 1 < argc ? argv[++k] : nullptr; };
+
+    if (arg == "-h" || arg == "--help")
+      return false;
+    else if (arg == "-q" || arg == "--quiet")
+      options.quiet = true;
+    else if (arg == "-o" || arg == "--output")
+    {
+      const char *v = next();
+      if (!v)
+        return false;
+      options.output = v;
+    }
+    else if (arg == "--to")
+    {
+      const char *v = next();
+      if (!v)
+        return false;
+
+      if (!strcmp(v, "json"))
+        options.format = OutputFormat::JSON;
+      else if (!strcmp(v, "bin"))
+        options.format = OutputFormat::ARCHIVE;
+      else
+        return false;
+    }
+    else if (arg == "--codec")
+    {
+      const char *v = next();
+      if (!v)
+        return false;
+
+      if (!strcmp(v, "none"))
+        options.compression.codec = attr::CompressionCodec::NONE;
+      else if (!strcmp(v, "lz4"))
+        options.compression.codec = attr::CompressionCodec::LZ4;
+      else if (!strcmp(v, "zstd"))
+        options.compression.codec = attr::CompressionCodec::ZSTD;
+      else
+        return false;
+    }
+    else if (arg == "--filter")
+    {
+      const char *v = next();
+      if (!v)
+        return false;
+
+      if (!strcmp(v, "none"))
+        options.compression.filter = attr::CompressionFilter::NONE;
+      else if (!strcmp(v, "shuffle"))
+        options.compression.filter = attr::CompressionFilter::SHUFFLE;
+      else if (!strcmp(v, "delta"))
+        options.compression.filter = attr::CompressionFilter::DELTA_SHUFFLE;
+      else
+        return false;
+    }
+    else if (arg == "--level" || arg == "--repeat" || arg == "-j" || arg == "--jobs")
+    {
+      const char *v = next();
+      if (!v)
+        return false;
+
+      int n = std::atoi(v);
+
+      if (arg == "--level")
+        options.compression.level = n;
+      else if (arg == "--repeat")
+        options.repeat = std::max(1, n);
+      else
+        options.njobs = (size_t)std::max(1, n);
+    }
+    else if (arg.size() > 1 && arg[0] == '-')
+      return false;
+    else
+      options.inputs.push_back(arg);
+  }
+
+  return true;
+}
+
+static bool is_archive_file(const fs::path &path)
+{
+  // see the PresetArchive header
+  char          magic[8] = {};
+  std::ifstream file(path, std::ios::binary);
+  file.read(magic, sizeof(magic));
+  return file.gcount() == sizeof(magic) && !memcmp(magic, "ATTRPRST", sizeof(magic));
+}
+
+static bool is_preset_extension(const fs::path &path)
+{
+  return path.extension() == ".json" || path.extension() == ".bin";
+}
+
+// Input files, directories being searched recursively (sorted for a stable output).
+static bool collect_files(const std::vector<std::string> &inputs,
+                          std::vector<InputFile>         &files)
+{
+  for (auto &input : inputs)
+  {
+    std::error_code ec;
+    fs::path        root(input);
+
+    if (fs::is_directory(root, ec))
+    {
+      std::vector<InputFile> dir_files;
+
+      for (auto &entry : fs::recursive_directory_iterator(root, ec))
+        if (entry.is_regular_file() && is_preset_extension(entry.path()))
+          dir_files.push_back({entry.path(), fs::relative(entry.path(), root)});
+
+      std::sort(dir_files.begin(),
+                dir_files.end(),
+                [](const InputFile &a, const InputFile &b) { return a.path < b.path; });
+
+      files.insert(files.end(), dir_files.begin(), dir_files.end());
+    }
+    else if (fs::is_regular_file(root, ec))
+      files.push_back({root, root.filename()});
+    else
+    {
+      std::cerr << "attr-preset: no such file or directory: " << input << "\n";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Call 'fct(k)' for k in [0, n) on 'njobs' worker threads. Items are handed out one at
+// a time, presets of very different sizes are then balanced across the workers.
+static void parallel_for_each(size_t n, size_t njobs, std::function<void(size_t)> fct)
+{
+  if (njobs == 0)
+    njobs = std::max(1u, std::thread::hardware_concurrency());
+  njobs = std::min(njobs, n);
+
+  std::atomic<size_t> next_index = 0;
+
+  auto worker = [&]()
+  {
+    for (size_t k = next_index++; k < n; k = next_index++)
+      fct(k);
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t k = 1; k < njobs; k++)
+    threads.emplace_back(worker);
+
+  worker();
+
+  for (auto &t : threads)
+    t.join();
+}
+
+// Read a preset, JSON or binary, as a JSON object {key: attribute state, ...}.
+static bool read_preset_json(const fs::path &path,
+                             nlohmann::json &preset,
+                             std::string    &error)
+{
+  if (is_archive_file(path))
+  {
+    attr::PresetArchive archive;
+
+    if (!archive.open(path.string()))
+    {
+      error = "invalid binary preset";
+      return false;
+    }
+
+    preset = nlohmann::json::object();
+
+    for (auto &key : archive.get_keys())
+    {
+      nlohmann::json json = archive.get_json(key);
+
+      if (json.is_null())
+      {
+        error = "corrupted attribute \"" + key + "\"";
+        return false;
+      }
+
+      preset[key] = std::move(json);
+    }
+
+    return true;
+  }
+
+  std::ifstream file(path, std::ios::binary);
+
+  if (!file.is_open())
+  {
+    error = "could not open file";
+    return false;
+  }
+
+  preset = nlohmann::json::parse(file, nullptr, false);
+
+  if (preset.is_discarded())
+  {
+    error = "invalid JSON";
+    return false;
+  }
+
+  if (!preset.is_object())
+  {
+    error = "not a JSON object";
+    return false;
+  }
+
+  return true;
+}
+
+static bool write_preset_json(const fs::path                  &path,
+                              nlohmann::json                 &&preset,
+                              bool                             to_archive,
+                              const attr::CompressionSettings &compression,
+                              std::string                     &error)
+{
+  std::error_code ec;
+  if (path.has_parent_path())
+    fs::create_directories(path.parent_path(), ec);
+
+  if (to_archive)
+  {
+    if (!attr::save_preset_archive_json(path.string(), std::move(preset), compression))
+    {
+      error = "could not write binary preset " + path.string();
+      return false;
+    }
+    return true;
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  file << preset.dump() << "\n";
+  file.close();
+
+  if (file.fail())
+  {
+    error = "could not write JSON preset " + path.string();
+    return false;
+  }
+
+  return true;
+}
+
+static bool is_archive_output(const Options &options, const fs::path &path)
+{
+  if (options.format != OutputFormat::AUTO)
+    return options.format == OutputFormat::ARCHIVE;
+  return path.extension() != ".json";
+}
+
+// Equality of attribute states, integers being compared exactly and floating point
+// numbers in single precision (the precision of the attribute values) so that a round
+// trip through a binary preset is not reported as a difference.
+static bool json_equal(const nlohmann::json &a, const nlohmann::json &b)
+{
+  if (a.is_number_integer() && b.is_number_integer())
+    return a == b;
+
+  if (a.is_number() && b.is_number())
+    return a.get<float>() == b.get<float>();
+
+  if (a.type() != b.type() || a.size() != b.size())
+    return false;
+
+  if (a.is_array())
+    return std::equal(a.begin(), a.end(), b.begin(), json_equal);
+
+  if (a.is_object())
+  {
+    for (auto &[key, v] : a.items())
+      if (!b.contains(key) || !json_equal(v, b[key]))
+        return false;
+    return true;
+  }
+
+  return a == b;
+}
+
+// Problems found in the attribute states of a preset, empty if it is well-formed.
+static std::vector<std::string> check_preset(const nlohmann::json &preset)
+{
+  std::vector<std::string> problems;
+
+  for (auto &[key, json] : preset.items())
+  {
+    if (!json.is_object())
+    {
+      problems.push_back(key + ": not a JSON object");
+      continue;
+    }
+
+    if (!json.contains("type") || !json["type"].is_number_integer() ||
+        json["type"].get<int>() < 0 ||
+        json["type"].get<int>() >= (int)attr::AttributeType::INVALID)
+    {
+      problems.push_back(key + ": missing or invalid attribute type");
+      continue;
+    }
+
+    if (!json.contains("label"))
+      problems.push_back(key + ": missing label");
+
+    attr::AttributeType type = json["type"].get<attr::AttributeType>();
+
+    for (auto &name : attr::archive_bulk_keys(type))
+    {
+      if (!json.contains(name))
+        continue;
+
+      // null values stand for non-finite numbers
+      const nlohmann::json &array = json[name];
+      bool                  is_valid = array.is_array() &&
+                      std::all_of(array.begin(),
+                                  array.end(),
+                                  [](const nlohmann::json &v)
+                                  { return v.is_number() || v.is_null(); });
+
+      if (!is_valid)
+        problems.push_back(key + ": \"" + name + "\" is not an array of numbers");
+    }
+  }
+
+  return problems;
+}
+
+// Attribute of the given type with default settings, the preset states are loaded into
+// it. nullptr for an invalid type.
+static std::unique_ptr<attr::AbstractAttribute> make_attribute(attr::AttributeType type)
+{
+  using namespace attr;
+
+  switch (type)
+  {
+  case AttributeType::BOOL: return std::make_unique<BoolAttribute>("", false);
+  case AttributeType::CHOICE:
+    return std::make_unique<ChoiceAttribute>("", std::vector<std::string>{""}, "");
+  case AttributeType::COLOR:
+    return std::make_unique<ColorAttribute>("", 0.f, 0.f, 0.f, 1.f);
+  case AttributeType::COLOR_GRADIENT: return std::make_unique<ColorGradientAttribute>("");
+  case AttributeType::ENUM:
+    return std::make_unique<EnumAttribute>("", std::map<std::string, int>{{"", 0}});
+  case AttributeType::FILENAME: return std::make_unique<FilenameAttribute>("", "");
+  case AttributeType::FLOAT: return std::make_unique<FloatAttribute>("", 0.f);
+  case AttributeType::HMAP_ARRAY:
+    return std::make_unique<ArrayAttribute>("", glm::ivec2(1, 1));
+  case AttributeType::HMAP_CLOUD: return std::make_unique<CloudAttribute>("");
+  case AttributeType::HMAP_PATH: return std::make_unique<PathAttribute>("");
+  case AttributeType::INT: return std::make_unique<IntAttribute>("", 0);
+  case AttributeType::RANGE: return std::make_unique<RangeAttribute>("");
+  case AttributeType::SEED: return std::make_unique<SeedAttribute>("");
+  case AttributeType::STRING: return std::make_unique<StringAttribute>("", "");
+  case AttributeType::VEC_FLOAT:
+    return std::make_unique<VecFloatAttribute>("", std::vector<float>{}, 0.f, 1.f);
+  case AttributeType::VEC_INT:
+    return std::make_unique<VecIntAttribute>("", std::vector<int>{}, 0, 1);
+  case AttributeType::VEC2FLOAT: return std::make_unique<Vec2FloatAttribute>("");
+  case AttributeType::WAVE_NB: return std::make_unique<WaveNbAttribute>("");
+  case AttributeType::RESOLUTION: return std::make_unique<ResolutionAttribute>("");
+  default: return nullptr;
+  }
+}
+
+// Attribute map with the keys and types of a well-formed preset (see check_preset).
+static AttrMap make_attribute_map(const nlohmann::json &preset)
+{
+  AttrMap attr_map;
+
+  for (auto &[key, json] : preset.items())
+    attr_map[key] = make_attribute(json["type"].get<attr::AttributeType>());
+
+  return attr_map;
+}
+
+// Number of errors logged by the library in the calling thread. The attribute loaders
+// (json_from) only report invalid states through the log, the count tells whether a
+// preset loaded without errors.
+class ErrorCountSink : public spdlog::sinks::base_sink<spdlog::details::null_mutex>
+{
+public:
+  static size_t get_count() { return count; }
+
+protected:
+  void sink_it_(const spdlog::details::log_msg &msg) override
+  {
+    if (msg.level >= spdlog::level::err)
+      count++;
+  }
+
+  void flush_() override {}
+
+private:
+  static inline thread_local size_t count = 0;
+};
+
+// Load a preset into the attributes of 'attr_map' with the library loaders (load_preset
+// or PresetArchive::load).
+static bool load_preset_attributes(const fs::path &path,
+                                   AttrMap        &attr_map,
+                                   std::string    &error)
+{
+  size_t nerrors = ErrorCountSink::get_count();
+  bool   ret = false;
+
+  try
+  {
+    if (is_archive_file(path))
+    {
+      attr::PresetArchive archive;
+      ret = archive.open(path.string()) && archive.load(attr_map);
+    }
+    else
+      ret = attr::load_preset(path.string(), attr_map);
+  }
+  catch (const std::exception &e)
+  {
+    error = std::string("could not load the attributes (") + e.what() + ")";
+    return false;
+  }
+
+  nerrors = ErrorCountSink::get_count() - nerrors;
+
+  if (!ret || nerrors > 0)
+  {
+    error = "could not load the attributes (" + std::to_string(nerrors) +
+            " error(s) logged)";
+    return false;
+  }
+
+  return true;
+}
+
+static int report(const std::vector<InputFile>  &files,
+                  const std::vector<FileResult> &results,
+                  const Options                 &options)
+{
+  size_t nfailed = 0;
+
+  for (size_t k = 0; k < files.size(); k++)
+  {
+    if (!results[k].ok)
+    {
+      nfailed++;
+      std::cout << "FAILED " << files[k].path.string() << ": " << results[k].message
+                << "\n";
+    }
+    else if (!options.quiet)
+      std::cout << "OK " << files[k].path.string()
+                << (results[k].message.empty() ? "" : " " + results[k].message) << "\n";
+  }
+
+  std::cout << files.size() << " preset(s), " << nfailed << " failed\n";
+
+  return nfailed ? 1 : 0;
+}
+
+// commands
+
+static int cmd_validate(const Options &options)
+{
+  std::vector<InputFile> files;
+  if (!collect_files(options.inputs, files))
+    return 2;
+
+  std::vector<FileResult> results(files.size());
+
+  parallel_for_each(files.size(),
+                    options.njobs,
+                    [&](size_t k)
+                    {
+                      nlohmann::json preset;
+                      FileResult    &r = results[k];
+
+                      if (!read_preset_json(files[k].path, preset, r.message))
+                      {
+                        r.ok = false;
+                        return;
+                      }
+
+                      std::vector<std::string> problems = check_preset(preset);
+
+                      for (auto &p : problems)
+                        r.message += (r.message.empty() ? "" : "; ") + p;
+
+                      r.ok = problems.empty();
+                      if (!r.ok)
+                        return;
+
+                      AttrMap attr_map = make_attribute_map(preset);
+
+                      r.ok = load_preset_attributes(files[k].path, attr_map, r.message);
+                      if (r.ok)
+                        r.message = "(" + std::to_string(preset.size()) + " attributes)";
+                    });
+
+  return report(files, results, options);
+}
+
+static int cmd_convert(const Options &options)
+{
+  if (options.output.empty())
+    return 2;
+
+  std::vector<InputFile> files;
+  if (!collect_files(options.inputs, files))
+    return 2;
+
+  // single file to file, every other case to a directory
+  bool to_file = files.size() == 1 && options.inputs.size() == 1 &&
+                 !fs::is_directory(options.inputs[0]) &&
+                 !fs::is_directory(options.output);
+
+  std::vector<FileResult> results(files.size());
+
+  parallel_for_each(
+      files.size(),
+      options.njobs,
+      [&](size_t k)
+      {
+        FileResult &r = results[k];
+        fs::path    out = fs::path(options.output);
+
+        if (!to_file)
+        {
+          bool to_archive = options.format != OutputFormat::JSON;
+          out /= files[k].relative;
+          out.replace_extension(to_archive ? ".bin" : ".json");
+        }
+
+        bool to_archive = is_archive_output(options, out);
+
+        std::error_code ec;
+        if (fs::equivalent(out, files[k].path, ec))
+        {
+          r = {false, "output would overwrite the input"};
+          return;
+        }
+
+        // streamed conversion from a binary preset to JSON
+        if (!to_archive && is_archive_file(files[k].path))
+        {
+          if (out.has_parent_path())
+            fs::create_directories(out.parent_path(), ec);
+
+          r.ok = attr::preset_archive_to_json(files[k].path.string(), out.string());
+          r.message = r.ok ? "-> " + out.string() : "conversion failed";
+          return;
+        }
+
+        nlohmann::json preset;
+        if (!read_preset_json(files[k].path, preset, r.message) ||
+            !write_preset_json(out,
+                               std::move(preset),
+                               to_archive,
+                               options.compression,
+                               r.message))
+        {
+          r.ok = false;
+          return;
+        }
+
+        r.message = "-> " + out.string();
+      });
+
+  return report(files, results, options);
+}
+
+static int cmd_diff(const Options &options)
+{
+  if (options.inputs.size() != 2)
+    return 2;
+
+  nlohmann::json a, b;
+  std::string    error;
+
+  for (int k = 0; k < 2; k++)
+    if (!read_preset_json(options.inputs[k], k ? b : a, error))
+    {
+      std::cerr << "attr-preset: " << options.inputs[k] << ": " << error << "\n";
+      return 1;
+    }
+
+  size_t ndiffs = 0;
+
+  // keys of JSON objects are sorted, single merge pass
+  auto it_a = a.begin();
+  auto it_b = b.begin();
+
+  while (it_a != a.end() || it_b != b.end())
+  {
+    if (it_b == b.end() || (it_a != a.end() && it_a.key() < it_b.key()))
+    {
+      std::cout << "- " << it_a.key() << "\n";
+      ++it_a;
+      ndiffs++;
+      continue;
+    }
+
+    if (it_a == a.end() || it_b.key() < it_a.key())
+    {
+      std::cout << "+ " << it_b.key() << "\n";
+      ++it_b;
+      ndiffs++;
+      continue;
+    }
+
+    const nlohmann::json &ja = it_a.value();
+    const nlohmann::json &jb = it_b.value();
+
+    if (!json_equal(ja, jb))
+    {
+      std::string members;
+
+      if (ja.is_object() && jb.is_object())
+      {
+        nlohmann::json all = ja;
+        all.update(jb);
+
+        for (auto &[name, _] : all.items())
+          if (!ja.contains(name) || !jb.contains(name) || !json_equal(ja[name], jb[name]))
+            members += (members.empty() ? "" : ", ") + name;
+      }
+
+      std::cout << "~ " << it_a.key() << (members.empty() ? "" : ": " + members) << "\n";
+      ndiffs++;
+    }
+
+    ++it_a;
+    ++it_b;
+  }
+
+  if (!options.quiet)
+    std::cout << ndiffs << " difference(s)\n";
+
+  return ndiffs ? 1 : 0;
+}
+
+static int cmd_merge(const Options &options)
+{
+  if (options.output.empty() || options.inputs.empty())
+    return 2;
+
+  nlohmann::json merged = nlohmann::json::object();
+  std::string    error;
+
+  for (auto &input : options.inputs)
+  {
+    nlohmann::json preset;
+
+    if (!read_preset_json(input, preset, error))
+    {
+      std::cerr << "attr-preset: " << input << ": " << error << "\n";
+      return 1;
+    }
+
+    merged.update(preset);
+  }
+
+  size_t count = merged.size();
+
+  if (!write_preset_json(options.output,
+                         std::move(merged),
+                         is_archive_output(options, options.output),
+                         options.compression,
+                         error))
+  {
+    std::cerr << "attr-preset: " << error << "\n";
+    return 1;
+  }
+
+  if (!options.quiet)
+    std::cout << count << " attribute(s) written to " << options.output << "\n";
+
+  return 0;
+}
+
+// Time the loading of the presets into attributes ('is_load'), or their reading as JSON
+// trees.
+static int cmd_bench(const Options &options, bool is_load)
+{
+  std::vector<InputFile> files;
+  if (!collect_files(options.inputs, files))
+    return 2;
+
+  using clock = std::chrono::steady_clock;
+
+  std::vector<FileResult> results(files.size());
+  std::atomic<uint64_t>   total_bytes = 0;
+  auto                    t0 = clock::now();
+
+  parallel_for_each(
+      files.size(),
+      options.njobs,
+      [&](size_t k)
+      {
+        FileResult &r = results[k];
+        double      tmin = 1e30;
+        double      tsum = 0.0;
+
+        std::error_code ec;
+        uint64_t        nbytes = fs::file_size(files[k].path, ec);
+
+        // the attributes are created from a first read, not timed
+        AttrMap attr_map;
+
+        if (is_load)
+        {
+          nlohmann::json preset;
+
+          if (!read_preset_json(files[k].path, preset, r.message) ||
+              !check_preset(preset).empty())
+          {
+            r.ok = false;
+            r.message = r.message.empty() ? "malformed preset" : r.message;
+            return;
+          }
+
+          attr_map = make_attribute_map(preset);
+        }
+
+        for (int it = 0; it < options.repeat; it++)
+        {
+          auto t_start = clock::now();
+
+          if (is_load)
+            r.ok = load_preset_attributes(files[k].path, attr_map, r.message);
+          else
+          {
+            nlohmann::json preset;
+            r.ok = read_preset_json(files[k].path, preset, r.message);
+          }
+
+          if (!r.ok)
+            return;
+
+          double t = std::chrono::duration<double, std::milli>(clock::now() - t_start)
+                         .count();
+          tmin = std::min(tmin, t);
+          tsum += t;
+        }
+
+        total_bytes += nbytes;
+
+        double mb = (double)nbytes / (1024.0 * 1024.0);
+        char   buffer[128];
+        std::snprintf(buffer,
+                      sizeof(buffer),
+                      "%.2f MB, min %.2f ms, mean %.2f ms, %.1f MB/s",
+                      mb,
+                      tmin,
+                      tsum / options.repeat,
+                      tmin > 0.0 ? mb / (tmin * 1e-3) : 0.0);
+        r.message = buffer;
+      });
+
+  double wall = std::chrono::duration<double>(clock::now() - t0).count();
+  double mb = (double)total_bytes / (1024.0 * 1024.0);
+  int    ret = report(files, results, options);
+
+  std::cout << "total " << mb << " MB in " << wall << " s (" << options.repeat
+            << (is_load ? " load(s)" : " read(s)") << " per preset), "
+            << (wall > 0.0 ? mb * options.repeat / wall : 0.0) << " MB/s\n";
+
+  return ret;
+}
+
+// main
+
+int main(int argc, char *argv[])
+{
+  Options options;
+
+  if (!parse_options(argc, argv, options))
+  {
+    std::cerr << usage_text;
+    return 2;
+  }
+
+  // the tool reports failures itself, only keep the library errors (printed unless
+  // quiet, always counted to check the loading of the presets)
+  auto &logger = attr::Logger::log();
+  logger->set_level(spdlog::level::err);
+
+  if (options.quiet)
+    for (auto &sink : logger->sinks())
+      sink->set_level(spdlog::level::off);
+
+  logger->sinks().push_back(std::make_shared<ErrorCountSink>());
+
+  if (options.compression.codec != attr::CompressionCodec::NONE &&
+      !attr::is_codec_available(options.compression.codec))
+    std::cerr << "attr-preset: codec not available in this build, presets are written "
+                 "without compression\n";
+
+  int ret = 2;
+
+  if (options.command == "validate")
+    ret = cmd_validate(options);
+  else if (options.command == "convert")
+    ret = cmd_convert(options);
+  else if (options.command == "diff")
+    ret = cmd_diff(options);
+  else if (options.command == "merge")
+    ret = cmd_merge(options);
+  else if (options.command == "bench")
+    ret = cmd_bench(options, true);
+  else if (options.command == "bench-read")
+    ret = cmd_bench(options, false);
+
+  if (ret == 2)
+    std::cerr << usage_text;
+
+  return ret;
+}